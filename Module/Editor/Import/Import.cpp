@@ -11,6 +11,7 @@
 #include <xxGraphicPlus/xxMesh.h>
 #include <xxGraphicPlus/xxNode.h>
 #include <xxGraphicPlus/xxTexture.h>
+#include <Runtime/Tools/NodeTools.h>
 #include "Import.h"
 
 //#define STBI_NO_JPEG
@@ -35,8 +36,10 @@
 bool Import::EnableAxisUpYToZ = false;
 bool Import::EnableMergeNode = false;
 bool Import::EnableMergeTexture = true;
+bool Import::EnableMeshLOD = false;
 bool Import::EnableOptimizeMesh = true;
 bool Import::EnableTextureFlipV = true;
+float Import::MeshLODErrors[4] = { 0.005f, 0.02f, 0.05f, 0.1f };
 //==============================================================================
 void Import::Initialize()
 {
@@ -104,12 +107,13 @@ void Import::MergeNode(xxNodePtr const& target, xxNodePtr const& source, xxNodeP
     {
         MergeNode(left, right, root);
         left->Modifiers = right->Modifiers;
+        NodeTools::Invalidate(left);
     }
 
     for (auto node : append)
     {
-        source->DetachChild(node);
-        target->AttachChild(node);
+        NodeTools::DetachChild(source, node);
+        NodeTools::AttachChild(target, node);
     }
 
     xxNode::Traversal(target, [&](xxNodePtr const& node)
@@ -129,6 +133,10 @@ void Import::MergeNode(xxNodePtr const& target, xxNodePtr const& source, xxNodeP
             }
             data.bone = to;
         }
+        if (node->Bones.empty() == false)
+        {
+            NodeTools::Invalidate(node);
+        }
         return true;
     });
 }
@@ -160,15 +168,6 @@ void Import::MergeTexture(xxNodePtr const& node)
 //------------------------------------------------------------------------------
 xxNodePtr Import::GetNodeByName(xxNodePtr const& root, std::string const& name)
 {
-    xxNodePtr output;
-
-    xxNode::Traversal(root, [&](xxNodePtr const& node)
-    {
-        if (node->Name == name)
-            output = node;
-        return output == nullptr;
-    });
-
-    return output;
+    return NodeTools::GetObject(root, name);
 }
 //==============================================================================
@@ -21,6 +21,8 @@ public:
     static bool EnableAxisUpYToZ;
     static bool EnableMergeNode;
     static bool EnableMergeTexture;
+    static bool EnableMeshLOD;
     static bool EnableOptimizeMesh;
     static bool EnableTextureFlipV;
+    static float MeshLODErrors[4];
 };
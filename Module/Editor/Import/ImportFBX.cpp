@@ -322,13 +322,7 @@ static xxMeshPtr CreateMesh(ufbx_mesh* mesh, xxNodePtr const& node, xxNodePtr co
             xxNodePtr to;
             if (from)
             {
-                char const* name = from->name.data;
-                xxNode::Traversal(root, [&](xxNodePtr const& node)
-                {
-                    if (node->Name == name)
-                        to = node;
-                    return to == nullptr;
-                });
+                to = Import::GetNodeByName(root, from->name.data);
             }
             if (to == nullptr)
             {
@@ -404,6 +398,10 @@ static xxNodePtr CreateNode(ufbx_node* node, xxNodePtr root)
         {
             geometryNode->Mesh = MeshTools::IndexingMesh(geometryNode->Mesh);
         }
+        if (Import::EnableMeshLOD)
+        {
+            geometryNode->Mesh = MeshTools::CreateLOD(geometryNode->Mesh, Import::MeshLODErrors, xxCountOf(Import::MeshLODErrors));
+        }
     }
     return output;
 }
@@ -7,6 +7,7 @@
 #include "Editor.h"
 #include <xxGraphicPlus/xxMesh.h>
 #include <meshoptimizer/src/meshoptimizer.h>
+#include <Tools/LODTools.h>
 #include "MeshTools.h"
 
 #define TAG "MeshTools"
@@ -264,6 +265,7 @@ xxMeshPtr MeshTools::CreateMeshlet(xxMeshPtr const& mesh)
 
     uint32_t vertex_count = 0;
     uint32_t triangle_count = 0;
+    std::vector<uint32_t> meshlet_indices;
     std::vector<MeshletStorage> storages;
     std::vector<uint32_t> meshlet_triangles32(max_meshlets * max_triangles);
     for (size_t i = 0; i < meshlet_count; ++i)
@@ -297,6 +299,12 @@ xxMeshPtr MeshTools::CreateMeshlet(xxMeshPtr const& mesh)
             indices |= meshlet_triangles[meshlet.triangle_offset + i * 3 + 2] << 16;
             meshlet_triangles32[storage.triangle_offset + i] = indices;
         }
+
+        // Index buffer in meshlet order for the CPU culling fallback
+        for (uint32_t i = 0; i < meshlet.triangle_count * 3; ++i)
+        {
+            meshlet_indices.push_back(meshlet_vertices[meshlet.vertex_offset + meshlet_triangles[meshlet.triangle_offset + i]]);
+        }
     }
 
     meshlets.resize(meshlet_count);
@@ -310,6 +318,11 @@ xxMeshPtr MeshTools::CreateMeshlet(xxMeshPtr const& mesh)
     memcpy(mesh->Storage[xxMesh::STORAGE0], storages.data(), storages.size() * xxSizeOf(MeshletStorage));
     memcpy(mesh->Storage[xxMesh::STORAGE1], meshlet_vertices.data(), meshlet_vertices.size() * xxSizeOf(uint32_t));
     memcpy(mesh->Storage[xxMesh::STORAGE2], meshlet_triangles32.data(), meshlet_triangles32.size() * xxSizeOf(uint32_t));
+    // The base index buffer is rewritten in meshlet order, the triangles are kept but their original order is not
+    if (meshlet_indices.size() == indices.size())
+    {
+        SetIndexToMesh(mesh, meshlet_indices);
+    }
 
     float time = xxGetCurrentTime() - begin;
 
@@ -318,6 +331,52 @@ xxMeshPtr MeshTools::CreateMeshlet(xxMeshPtr const& mesh)
     return mesh;
 }
 //------------------------------------------------------------------------------
+xxMeshPtr MeshTools::CreateLOD(xxMeshPtr const& mesh, float const* errors, int count)
+{
+    if (mesh == nullptr)
+        return nullptr;
+    if (mesh->Count[xxMesh::INDEX] == 0)
+        return mesh;
+
+    float begin = xxGetCurrentTime();
+
+    std::vector<uint32_t> indices = GetIndexFromMesh(mesh);
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<float> levelErrors;
+    size_t previous_count = indices.size();
+    float previous_error = 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        float target_error = errors[i];
+        if (target_error <= previous_error)
+            continue;
+
+        float result_error = 0.0f;
+        std::vector<uint32_t> lod(indices.size());
+        size_t index_count = meshopt_simplify(lod.data(), indices.data(), indices.size(),
+                                              (float*)mesh->Vertex, mesh->Count[xxMesh::VERTEX], mesh->VertexStride,
+                                              0, target_error, 0, &result_error);
+
+        // Skip levels which do not remove at least a tenth of the previous level
+        if (index_count == 0 || index_count > previous_count * 9 / 10)
+            continue;
+        lod.resize(index_count);
+        meshopt_optimizeVertexCache(lod.data(), lod.data(), lod.size(), mesh->Count[xxMesh::VERTEX]);
+
+        previous_count = index_count;
+        previous_error = std::max(result_error, previous_error);
+        levels.push_back(lod);
+        levelErrors.push_back(previous_error);
+    }
+    LODTools::SetLevels(mesh, levels, levelErrors);
+
+    float time = xxGetCurrentTime() - begin;
+
+    xxLog(TAG, "CreateLOD : %s Level count %zu (%.0fus)", mesh->Name.c_str(), levels.size(), time * 1000000);
+
+    return mesh;
+}
+//------------------------------------------------------------------------------
 xxMeshPtr MeshTools::IndexingMesh(xxMeshPtr const& mesh)
 {
     if (mesh == nullptr)
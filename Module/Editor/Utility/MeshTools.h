@@ -32,6 +32,7 @@ struct MeshTools
     static xxMeshPtr CreateMeshFromMeshData(MeshData const& data);
     static xxMeshPtr CreateMesh(std::vector<xxVector3> const& vertices, std::vector<xxVector3> const& normals, std::vector<xxVector4> const& colors, std::vector<xxVector2> const& textures);
     static xxMeshPtr CreateMeshlet(xxMeshPtr const& mesh);
+    static xxMeshPtr CreateLOD(xxMeshPtr const& mesh, float const* errors, int count);
     static xxMeshPtr IndexingMesh(xxMeshPtr const& mesh);
     static xxMeshPtr NormalizeMesh(xxMeshPtr const& mesh, bool tangent);
     static xxMeshPtr OptimizeMesh(xxMeshPtr const& mesh);
@@ -8,6 +8,7 @@
 #include <xxGraphicPlus/xxCamera.h>
 #include <xxGraphicPlus/xxMaterial.h>
 #include <xxGraphicPlus/xxNode.h>
+#include <Tools/BVH.h>
 #include <Tools/CameraTools.h>
 #include <Tools/DrawTools.h>
 #if HAVE_MINIGUI
@@ -189,6 +190,9 @@ void Game::Callback(const ImDrawList* list, const ImDrawCmd* cmd)
     drawData.commandEncoder = commandEncoder;
     drawData.camera2D = screenCamera;
     drawData.camera3D = sceneCamera;
+    drawData.bvh = BVH::Current;
+    drawData.lodError = 1.0f / viewport_height;
+    drawData.sort = true;
     drawData.materialIndex = 1;
 
     if (sceneCamera)
@@ -10,6 +10,7 @@
 #include <xxGraphicPlus/xxNode.h>
 #include <Graphic/Binary.h>
 #include <MiniGUI/Window.h>
+#include <Runtime/Modifier/LightModifier.h>
 #include <Runtime/Tools/NodeTools.h>
 #include <ImGuiFileDialog/ImGuiFileDialog.h>
 #include "Import/ImportFBX.h"
@@ -52,20 +53,27 @@ static void AddCamera(xxNodePtr const& root)
     node->Camera->Location = root->WorldBound.xyz - xxVector3::Y * root->WorldBound.z * 2.0f;
     node->Camera->SetFOV(16.0f / 9.0f, 60.0f, 10000.0f);
     node->Camera->LightDirection.y = -1.0f;
-    root->AttachChild(node);
+    NodeTools::AttachChild(root, node);
+}
+//------------------------------------------------------------------------------
+static void AddLight(xxNodePtr const& root)
+{
+    auto node = xxNode::Create();
+    node->Modifiers.push_back({LightModifier::Create()});
+    NodeTools::AttachChild(root, node);
 }
 //------------------------------------------------------------------------------
 static void AddNode(xxNodePtr const& root)
 {
     auto node = xxNode::Create();
-    root->AttachChild(node);
+    NodeTools::AttachChild(root, node);
 }
 //------------------------------------------------------------------------------
 #if HAVE_MINIGUI
 static void AddWindow(xxNodePtr const& root)
 {
     auto window = MiniGUI::Window::Create();
-    root->AttachChild(window);
+    NodeTools::AttachChild(root, window);
 }
 #endif
 //------------------------------------------------------------------------------
@@ -157,6 +165,11 @@ void Hierarchy::Import(const UpdateData& updateData)
         ImGui::Checkbox("Axis Up Y to Z", &Import::EnableAxisUpYToZ);
         ImGui::Checkbox("Merge Node", &Import::EnableMergeNode);
         ImGui::Checkbox("Merge Texture", &Import::EnableMergeTexture);
+        ImGui::Checkbox("Mesh LOD", &Import::EnableMeshLOD);
+        if (Import::EnableMeshLOD)
+        {
+            ImGui::InputFloat4("LOD Error", Import::MeshLODErrors, "%.3f");
+        }
         ImGui::Checkbox("Optimize Mesh", &Import::EnableOptimizeMesh);
         ImGui::Checkbox("Texture Flip V", &Import::EnableTextureFlipV);
         if (ImGui::Button("Import"))
@@ -170,7 +183,7 @@ void Hierarchy::Import(const UpdateData& updateData)
                 }
                 else
                 {
-                    importNode->AttachChild(node);
+                    NodeTools::AttachChild(importNode, node);
                 }
                 if (Import::EnableMergeTexture)
                 {
@@ -306,7 +319,7 @@ bool Hierarchy::Update(const UpdateData& updateData, bool& show, xxNodePtr const
                         }
                         else
                         {
-                            node->AttachChild(object);
+                            NodeTools::AttachChild(node, object);
                         }
 
                         xxNodePtr const& root = NodeTools::GetRoot(node);
@@ -484,6 +497,17 @@ bool Hierarchy::Update(const UpdateData& updateData, bool& show, xxNodePtr const
                 selectedRight->Flags |= TEST_OPEN_FLAG;
                 selectedRight = nullptr;
             }
+#if HAVE_MINIGUI
+            if (selectedRight && (selectedRight == root || MiniGUI::Window::Cast(selectedRight) == nullptr) && ImGui::Button("Add Light"))
+#else
+            if (selectedRight && ImGui::Button("Add Light"))
+#endif
+            {
+                update = true;
+                AddLight(selectedRight);
+                selectedRight->Flags |= TEST_OPEN_FLAG;
+                selectedRight = nullptr;
+            }
 #if HAVE_MINIGUI
             if (selectedRight && (selectedRight == root || MiniGUI::Window::Cast(selectedRight) != nullptr) && ImGui::Button("Add Window"))
             {
@@ -502,7 +526,7 @@ bool Hierarchy::Update(const UpdateData& updateData, bool& show, xxNodePtr const
                     Inspector::Select(nullptr);
                     Scene::Select(nullptr);
                 }
-                selectedRight->GetParent()->DetachChild(selectedRight);
+                NodeTools::DetachChild(selectedRight->GetParent(), selectedRight);
                 selectedRight = nullptr;
             }
             ImGui::Separator();
@@ -11,7 +11,9 @@
 #include <xxGraphicPlus/xxTexture.h>
 #include <Runtime/Graphic/Material.h>
 #include <Runtime/MiniGUI/Window.h>
+#include <Runtime/Modifier/LightModifier.h>
 #include <Runtime/Modifier/Modifier.h>
+#include <Runtime/Tools/LODTools.h>
 #include <Runtime/Tools/NodeTools.h>
 #include "Utility/Tools.h"
 #include "Log.h"
@@ -111,7 +113,9 @@ void Inspector::UpdateNode(const UpdateData& updateData, xxNodePtr const& node)
 {
     if (ImGui::CollapsingHeader(ICON_FA_CUBE "Node" Q, nullptr, ImGuiTreeNodeFlags_DefaultOpen))
     {
-        ImGui::InputTextEx("Name" Q, nullptr, node->Name);
+        std::string name = node->Name;
+        if (ImGui::InputTextEx("Name" Q, nullptr, name))
+            NodeTools::SetName(node, name);
         ImGui::SliderFloat3("Local" Q, node->LocalMatrix[0], -1.0f, 1.0f);
         ImGui::SliderFloat3("" Q, node->LocalMatrix[1], -1.0f, 1.0f);
         ImGui::SliderFloat3("" Q, node->LocalMatrix[2], -1.0f, 1.0f);
@@ -326,6 +330,7 @@ void Inspector::UpdateMesh(const UpdateData& updateData, xxMeshPtr const& mesh)
         int i[2] = { mesh->IndexCount, mesh->VertexCount < 65536 ? 16 : 32 };
         int v[2] = { mesh->VertexCount, mesh->VertexStride };
         int s[2] = { mesh->Count[xxMesh::STORAGE0], mesh->Stride[xxMesh::STORAGE0] };
+        int l = LODTools::GetLevelCount(mesh);
         ImGui::InputTextEx("Name" Q, nullptr, mesh->Name);
         ImGui::InputInt3("Attribute" Q, a, ImGuiInputTextFlags_ReadOnly);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Normal Count : %d\nColor Count : %d\nTexture Count : %d", a[0], a[1], a[2]);
@@ -335,6 +340,18 @@ void Inspector::UpdateMesh(const UpdateData& updateData, xxMeshPtr const& mesh)
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Vertex Count : %d\nVertex Stride : %d", v[0], v[1]);
         ImGui::InputInt2("Storage" Q, s,  ImGuiInputTextFlags_ReadOnly);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Storage Count : %d\nStorage Stride : %d", s[0], s[1]);
+        ImGui::InputInt("LOD" Q, &l, 0, 0, ImGuiInputTextFlags_ReadOnly);
+        if (ImGui::IsItemHovered())
+        {
+            std::string tooltip;
+            for (int i = 0; i < l; ++i)
+            {
+                xxMeshPtr const& level = LODTools::GetLevel(mesh, i);
+                tooltip += "Level " + std::to_string(i) + " : " + std::to_string(level->IndexCount / 3) + " Triangles";
+                tooltip += " (" + std::to_string(LODTools::GetLevelError(mesh, i)) + ")\n";
+            }
+            ImGui::SetTooltip("%s", tooltip.c_str());
+        }
         ImGui::InputFloat3("Bound" Q, (float*)&mesh->Bound, "%.3f", ImGuiInputTextFlags_ReadOnly);
         ImGui::InputFloat("" Q, (float*)&mesh->Bound.w, 0, 0, "%.3f", ImGuiInputTextFlags_ReadOnly);
     }
@@ -359,6 +376,15 @@ void Inspector::UpdateModifier(const UpdateData& updateData, std::vector<xxModif
                 ImGui::InputInt("Count" Q, (int*)&count, 0, 0, ImGuiInputTextFlags_ReadOnly);
                 ImGui::InputFloat("Time" Q, (float*)&data.time, 0, 0, "%.3f", ImGuiInputTextFlags_ReadOnly);
                 ImGui::InputInt("Index" Q, (int*)&data.index, 0, 0, ImGuiInputTextFlags_ReadOnly);
+                if (data.modifier->DataType == Modifier::LIGHT && size >= sizeof(LightModifier::Constant))
+                {
+                    auto* constant = (LightModifier::Constant*)data.modifier->Data.data();
+                    ImGui::Separator();
+                    ImGui::ColorEdit3("Color" Q, constant->color);
+                    ImGui::SliderFloat("Intensity" Q, &constant->intensity, 0.0f, 10.0f);
+                    ImGui::SliderFloat("Range" Q, &constant->range, 0.0f, 1000.0f);
+                    ImGui::SliderFloat2("Spot Angle" Q, &constant->innerAngle, 0.0f, 90.0f);
+                }
             }
         }
     }
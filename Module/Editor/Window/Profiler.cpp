@@ -6,9 +6,11 @@
 //==============================================================================
 #include "Editor.h"
 #include <map>
+#include <Runtime/Graphic/Resource.h>
 #include "Profiler.h"
 
 static std::map<unsigned int, std::pair<char const*, double>> times;
+static std::map<unsigned int, size_t> timeCounts;
 static std::map<unsigned int, std::pair<char const*, size_t>> counters;
 //------------------------------------------------------------------------------
 void Profiler::Initialize()
@@ -19,6 +21,7 @@ void Profiler::Initialize()
 void Profiler::Shutdown()
 {
     times.clear();
+    timeCounts.clear();
     counters.clear();
 }
 //------------------------------------------------------------------------------
@@ -34,13 +37,25 @@ bool Profiler::Update(const UpdateData& updateData, bool& show)
             static uint64_t const min = 0;
             static uint64_t const max = NSEC_PER_SEC / 60;
             uint64_t value = uint64_t(pair.second * NSEC_PER_SEC);
-            ImGui::SliderScalar(pair.first, ImGuiDataType_U64, &value, &min, &max, "%lluus", ImGuiInputTextFlags_ReadOnly);
+            char format[64] = "%lluus";
+            auto it = timeCounts.find(hashName);
+            if (it != timeCounts.end())
+                snprintf(format, sizeof(format), "%%lluus / %zu", (*it).second);
+            ImGui::SliderScalar(pair.first, ImGuiDataType_U64, &value, &min, &max, format, ImGuiInputTextFlags_ReadOnly);
         }
         for (auto const& [hashName, pair] : counters)
         {
             uint64_t value = uint64_t(pair.second);
             ImGui::InputScalar(pair.first, ImGuiDataType_U64, &value, nullptr, nullptr, "%llu", ImGuiInputTextFlags_ReadOnly);
         }
+        ImGui::Separator();
+        ImGui::TextUnformatted("Count / Bytes / Created / Hit / Miss / Pending");
+        for (int i = 0; i < Resource::TYPE_COUNT; ++i)
+        {
+            Resource::Statistic const& statistic = Resource::Get(Resource::Type(i));
+            uint64_t values[6] = { statistic.count, statistic.bytes, statistic.created, statistic.hit, statistic.miss, statistic.pending };
+            ImGui::InputScalarN(Resource::Name(Resource::Type(i)), ImGuiDataType_U64, values, 6, nullptr, nullptr, "%llu", ImGuiInputTextFlags_ReadOnly);
+        }
     }
     ImGui::End();
 
@@ -115,6 +130,50 @@ void Profiler::Count(unsigned int hashName, size_t count)
     case xxHash("Node Active Count"):
         counters[hashName] = {"Node Active Count", count};
         break;
+    case xxHash("Node Culled Count"):
+        counters[hashName] = {"Node Culled Count", count};
+        break;
+    case xxHash("Node Occluded Count"):
+        counters[hashName] = {"Node Occluded Count", count};
+        break;
+    case xxHash("Sort Overflow Count"):
+        counters[hashName] = {"Sort Overflow Count", count};
+        break;
+    case xxHash("Occluder Triangle Count"):
+        counters[hashName] = {"Occluder Triangle Count", count};
+        break;
+    case xxHash("Binding Issued Count"):
+        counters[hashName] = {"Binding Issued Count", count};
+        break;
+    case xxHash("Binding Elided Count"):
+        counters[hashName] = {"Binding Elided Count", count};
+        break;
+    case xxHash("Meshlet Culled Count"):
+        counters[hashName] = {"Meshlet Culled Count", count};
+        break;
+    case xxHash("Palette Count"):
+        counters[hashName] = {"Palette Count", count};
+        break;
+    case xxHash("Palette Reused Count"):
+        counters[hashName] = {"Palette Reused Count", count};
+        break;
+    case xxHash("Skinned Mesh Count"):
+        counters[hashName] = {"Skinned Mesh Count", count};
+        break;
+    case xxHash("Skinning Skipped Count"):
+        counters[hashName] = {"Skinning Skipped Count", count};
+        break;
+    case xxHash("Light Count"):
+        counters[hashName] = {"Light Count", count};
+        break;
+    case xxHash("Light Cluster Count"):
+        counters[hashName] = {"Light Cluster Count", count};
+        break;
+#if HAVE_MINIGUI
+    case xxHash("MiniGUI Update"):
+        timeCounts[hashName] = count;
+        break;
+#endif
     }
 }
 //------------------------------------------------------------------------------
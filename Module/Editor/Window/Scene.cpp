@@ -12,9 +12,15 @@
 #include <xxGraphicPlus/xxNode.h>
 #include <xxGraphicPlus/xxTexture.h>
 #include <ImGuizmo/ImGuizmo.cpp>
+#include <Graphic/Binding.h>
+#include <Tools/BVH.h>
 #include <Tools/CameraTools.h>
 #include <Tools/DrawTools.h>
+#include <Tools/LightTools.h>
+#include <Tools/MeshletTools.h>
 #include <Tools/NodeTools.h>
+#include <Tools/OcclusionTools.h>
+#include <Tools/SkinningTools.h>
 #if HAVE_MINIGUI
 #include <MiniGUI/Window.h>
 #endif
@@ -35,12 +41,17 @@ xxNodePtr Scene::selected;
 static xxVector3 sceneArcball = {0.85f, -M_PI_2, 14.0f};
 static xxVector3 mainCameraOffset = {1.0f, 0.0f, 0.0f};
 static xxNodePtr sceneGrid;
+static BVH sceneBVH;
 static xxVector2 viewPos;
 static xxVector2 viewSize;
 static ImGuiViewport* viewViewport;
 static bool drawBoneLine = false;
 static bool drawNodeLine = false;
 static bool drawNodeBound = false;
+static bool drawSort = true;
+static bool drawLOD = true;
+static bool drawOcclusion = false;
+static bool drawOcclusionBuffer = false;
 //------------------------------------------------------------------------------
 void Scene::Initialize()
 {
@@ -103,6 +114,9 @@ void Scene::Shutdown(bool suspend)
     if (suspend)
         return;
 
+    if (BVH::Current == &sceneBVH)
+        BVH::Current = nullptr;
+    sceneBVH.Clear();
     screenCamera = nullptr;
     mainCamera = nullptr;
     sceneRoot = nullptr;
@@ -207,6 +221,37 @@ void Scene::DrawNodeBound(xxNodePtr const& root)
     }
 }
 //------------------------------------------------------------------------------
+static void DrawOcclusionBuffer()
+{
+    int const block = 4;
+    float const* depth = OcclusionTools::GetDepth();
+    float nearest = 0.0f;
+    for (int i = 0; i < OcclusionTools::WIDTH * OcclusionTools::HEIGHT; ++i)
+        nearest = std::max(nearest, depth[i]);
+    if (nearest <= 0.0f)
+        return;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float scaleX = viewSize.x / OcclusionTools::WIDTH;
+    float scaleY = viewSize.y / OcclusionTools::HEIGHT;
+    for (int y = 0; y < OcclusionTools::HEIGHT; y += block)
+    {
+        for (int x = 0; x < OcclusionTools::WIDTH; x += block)
+        {
+            float value = 0.0f;
+            for (int j = 0; j < block; ++j)
+                for (int i = 0; i < block; ++i)
+                    value = std::max(value, depth[(y + j) * OcclusionTools::WIDTH + x + i]);
+            if (value <= 0.0f)
+                continue;
+            int gray = int(255 * value / nearest);
+            ImVec2 from = { viewPos.x + x * scaleX, viewPos.y + y * scaleY };
+            ImVec2 to = { from.x + block * scaleX, from.y + block * scaleY };
+            drawList->AddRectFilled(from, to, IM_COL32(gray, gray, gray, 160));
+        }
+    }
+}
+//------------------------------------------------------------------------------
 static bool CameraMoveWASD(const UpdateData& updateData, bool mani)
 {
     ImGuiIO& io = ImGui::GetIO();
@@ -310,6 +355,29 @@ static bool CameraMoveManipulate(bool mani, ImVec2 const& maniSize, ImVec2 const
     return false;
 }
 //------------------------------------------------------------------------------
+static void NodePick(bool mani)
+{
+    if (mani || ImGuizmo::IsOver() || ImGuizmo::IsUsing() || Scene::mainCamera == nullptr)
+        return;
+    if (ImGui::IsWindowHovered() == false || ImGui::IsMouseClicked(ImGuiMouseButton_Left) == false)
+        return;
+
+    ImVec2 mousePos = ImGui::GetIO().MousePos;
+    float x = (mousePos.x - viewPos.x) / viewSize.x;
+    float y = (mousePos.y - viewPos.y) / viewSize.y;
+    if (x < 0.0f || x > 1.0f || y < 0.0f || y > 1.0f)
+        return;
+
+    xxVector3 direction = CameraTools::GetDirectionFromScreenPos(Scene::mainCamera, x, 1.0f - y);
+    xxNodePtr node = sceneBVH.Pick(Scene::mainCamera->Location, direction);
+    if (node)
+    {
+        Hierarchy::Select(node);
+        Inspector::Select(node);
+        Scene::Select(node);
+    }
+}
+//------------------------------------------------------------------------------
 #if HAVE_MINIGUI
 static void MiniGUIEditor(MiniGUI::WindowPtr const& window)
 {
@@ -445,68 +513,27 @@ bool Scene::Update(const UpdateData& updateData, bool& show)
         NodeTools::UpdateNodeFlags(sceneRoot);
 
         // Count
-        struct
-        {
-            size_t bone;
-            size_t nodeTotal;
-            size_t nodeActive;
-            size_t modifierTotal;
-            size_t modifierActive;
-        } Count = {};
-        auto callback = [&](xxNodePtr const& node)
-        {
-            node->Flags &= ~NodeTools::TEST_CHECK_FLAG;
-            for (auto const& data : node->Bones)
-            {
-                if (data.bone.use_count())
-                {
-                    xxNodePtr const& bone = (xxNodePtr&)data.bone;
-                    if ((bone->Flags & NodeTools::TEST_CHECK_FLAG) == 0)
-                    {
-                        bone->Flags |= NodeTools::TEST_CHECK_FLAG;
-                        Count.bone++;
-                    }
-                }
-            }
-            Count.nodeTotal++;
-            Count.modifierTotal += node->Modifiers.size();
-            if ((node->Flags & xxNode::UPDATE_SKIP) == 0)
-            {
-                Count.nodeActive++;
-                Count.modifierActive += node->Modifiers.size();
-            }
-            return true;
-        };
-        for (xxNodePtr const& node : (*sceneRoot))
-        {
-#if HAVE_MINIGUI
-            if (MiniGUI::Window::Cast(node))
-                continue;
-#endif
-            xxNode::Traversal(node, callback);
-        }
-        Profiler::Count(xxHash("Bone Count"), Count.bone);
-        Profiler::Count(xxHash("Node Total Count"), Count.nodeTotal);
-        Profiler::Count(xxHash("Node Active Count"), Count.nodeActive);
-        Profiler::Count(xxHash("Modifier Total Count"), Count.modifierTotal);
-        Profiler::Count(xxHash("Modifier Active Count"), Count.modifierActive);
-        updated |= Count.modifierTotal != 0;
+        NodeTools::Statistic const& statistic = NodeTools::GetStatistic(sceneRoot);
+        Profiler::Count(xxHash("Bone Count"), statistic.bone);
+        Profiler::Count(xxHash("Node Total Count"), statistic.nodeTotal);
+        Profiler::Count(xxHash("Node Active Count"), statistic.nodeActive);
+        Profiler::Count(xxHash("Modifier Total Count"), statistic.modifierTotal);
+        Profiler::Count(xxHash("Modifier Active Count"), statistic.modifierActive);
+        updated |= statistic.modifierTotal != 0;
 
         // Scene
         Profiler::Begin(xxHash("Scene Update"));
-        for (xxNodePtr const& node : (*sceneRoot))
-        {
-#if HAVE_MINIGUI
-            if (MiniGUI::Window::Cast(node))
-                continue;
-#endif
-            node->Update(updateData.time);
-        }
+        NodeTools::UpdateParallel(sceneRoot, updateData.time);
         sceneRoot->UpdateBound();
+        sceneBVH.Update(sceneRoot);
+        BVH::Current = &sceneBVH;
         Profiler::End(xxHash("Scene Update"));
 
         // MiniGUI
         Profiler::Begin(xxHash("MiniGUI Update"));
+#if HAVE_MINIGUI
+        size_t windowUpdateCount = MiniGUI::Window::UpdateCount;
+#endif
         for (xxNodePtr const& node : (*sceneRoot))
         {
 #if HAVE_MINIGUI
@@ -517,6 +544,9 @@ bool Scene::Update(const UpdateData& updateData, bool& show)
             }
 #endif
         }
+#if HAVE_MINIGUI
+        Profiler::Count(xxHash("MiniGUI Update"), MiniGUI::Window::UpdateCount - windowUpdateCount);
+#endif
         Profiler::End(xxHash("MiniGUI Update"));
 
         if (show)
@@ -551,6 +581,49 @@ bool Scene::Update(const UpdateData& updateData, bool& show)
         {
             ImGui::SetTooltip("%s", "Draw Node Bound");
         }
+        ImGui::SameLine();
+        ImGui::Checkbox("##4", &drawSort);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Sort Render Queue");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("##5", &drawLOD);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Mesh Level of Detail");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("##6", &drawOcclusion);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Occlusion Culling");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("##7", &drawOcclusionBuffer);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Draw Occlusion Buffer");
+        }
+        ImGui::SameLine();
+        if (ImGui::Checkbox("##8", &SkinningTools::Force))
+        {
+            // Skinned materials are built for one vertex layout
+            xxNode::Traversal(sceneRoot, [](xxNodePtr const& node)
+            {
+                if (node->Bones.empty() == false)
+                {
+                    node->Invalidate();
+                    if (node->Material)
+                        node->Material->Invalidate();
+                }
+                return true;
+            });
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Software Skinning");
+        }
 
         sceneCamera = nullptr;
         for (xxNodePtr const& node : (*Scene::sceneRoot))
@@ -584,6 +657,11 @@ bool Scene::Update(const UpdateData& updateData, bool& show)
 
         Tools::Draw(mainCamera, viewSize, viewPos);
 
+        if (drawOcclusion && drawOcclusionBuffer)
+        {
+            DrawOcclusionBuffer();
+        }
+
 #if HAVE_MINIGUI
         MiniGUIEditor(MiniGUI::Window::Cast(selected));
 #endif
@@ -623,6 +701,12 @@ bool Scene::Update(const UpdateData& updateData, bool& show)
         ImVec2 maniPos = ImVec2(viewPos.x + viewSize.x - maniSize.x, viewPos.y);
         bool mani = ImGui::IsMouseHoveringRect(maniPos, { maniPos.x + maniSize.x, maniPos.y + maniSize.y });
 
+#if HAVE_MINIGUI
+        if (MiniGUI::Window::Cast(selected) == nullptr)
+#endif
+        {
+            NodePick(mani);
+        }
         updated |= CameraMoveWASD(updateData, mani);
         updated |= CameraMoveManipulate(mani, maniSize, maniPos);
     }
@@ -700,8 +784,34 @@ void Scene::Callback(const ImDrawList* list, const ImDrawCmd* cmd)
         sceneCamera->GetFrustumPlanes(frustum[0], frustum[1], frustum[2], frustum[3], frustum[4], frustum[5]);
     }
 
+    size_t issuedCount = Binding::IssuedCount;
+    size_t elidedCount = Binding::ElidedCount;
+    size_t meshletCulledCount = MeshletTools::CulledCount;
+    size_t paletteCount = SkinningTools::PaletteCount;
+    size_t paletteReusedCount = SkinningTools::ReusedCount;
+    size_t skinnedCount = SkinningTools::SkinnedCount;
+    size_t skinningSkippedCount = SkinningTools::SkippedCount;
+    size_t lightCount = LightTools::LightCount;
+    size_t lightClusterCount = LightTools::ClusterCount;
     Profiler::Begin(xxHash("Scene Render"));
+    drawData.bvh = &sceneBVH;
+    drawData.sort = drawSort;
+    drawData.lodError = drawLOD ? 1.0f / viewport_height : 0.0f;
+    drawData.occlusion = drawOcclusion;
     DrawTools::Draw(drawData, sceneRoot);
     Profiler::End(xxHash("Scene Render"));
+    Profiler::Count(xxHash("Node Culled Count"), drawData.culledCount);
+    Profiler::Count(xxHash("Node Occluded Count"), drawData.occludedCount);
+    Profiler::Count(xxHash("Sort Overflow Count"), drawData.sortOverflowCount);
+    Profiler::Count(xxHash("Occluder Triangle Count"), OcclusionTools::TriangleCount);
+    Profiler::Count(xxHash("Binding Issued Count"), Binding::IssuedCount - issuedCount);
+    Profiler::Count(xxHash("Binding Elided Count"), Binding::ElidedCount - elidedCount);
+    Profiler::Count(xxHash("Meshlet Culled Count"), MeshletTools::CulledCount - meshletCulledCount);
+    Profiler::Count(xxHash("Palette Count"), SkinningTools::PaletteCount - paletteCount);
+    Profiler::Count(xxHash("Palette Reused Count"), SkinningTools::ReusedCount - paletteReusedCount);
+    Profiler::Count(xxHash("Skinned Mesh Count"), SkinningTools::SkinnedCount - skinnedCount);
+    Profiler::Count(xxHash("Skinning Skipped Count"), SkinningTools::SkippedCount - skinningSkippedCount);
+    Profiler::Count(xxHash("Light Count"), LightTools::LightCount - lightCount);
+    Profiler::Count(xxHash("Light Cluster Count"), LightTools::ClusterCount - lightClusterCount);
 }
 //------------------------------------------------------------------------------
@@ -28,6 +28,11 @@ static uint64_t bindFragmentSamplers[16];
 static uint64_t bindMeshConstantBuffer;
 static uint64_t bindVertexConstantBuffer;
 static uint64_t bindFragmentConstantBuffer;
+size_t Binding::IssuedCount;
+size_t Binding::ElidedCount;
+int Binding::InstanceCount;
+int Binding::IndexRangeCount;
+int const* Binding::IndexRanges;
 //------------------------------------------------------------------------------
 static void (*xxEndRenderPassSystem)(uint64_t commandEncoder, uint64_t framebuffer, uint64_t renderPass);
 static void (*xxSetViewportSystem)(uint64_t commandEncoder, int x, int y, int width, int height, float minZ, float maxZ);
@@ -42,6 +47,8 @@ static void (*xxSetFragmentSamplersSystem)(uint64_t commandEncoder, int count, c
 static void (*xxSetMeshConstantBufferSystem)(uint64_t commandEncoder, uint64_t buffer, int size);
 static void (*xxSetVertexConstantBufferSystem)(uint64_t commandEncoder, uint64_t buffer, int size);
 static void (*xxSetFragmentConstantBufferSystem)(uint64_t commandEncoder, uint64_t buffer, int size);
+static void (*xxDrawSystem)(uint64_t commandEncoder, int vertexCount, int instanceCount, int firstVertex, int firstInstance);
+static void (*xxDrawIndexedSystem)(uint64_t commandEncoder, uint64_t indexBuffer, int indexCount, int vertexCount, int instanceCount, int firstIndex, int vertexOffset, int firstInstance);
 //------------------------------------------------------------------------------
 static void xxEndRenderPassRuntime(uint64_t commandEncoder, uint64_t framebuffer, uint64_t renderPass)
 {
@@ -57,13 +64,20 @@ static void xxEndRenderPassRuntime(uint64_t commandEncoder, uint64_t framebuffer
     bindMeshConstantBuffer = 0;
     bindVertexConstantBuffer = 0;
     bindFragmentConstantBuffer = 0;
+    Binding::InstanceCount = 0;
+    Binding::IndexRangeCount = 0;
+    Binding::IndexRanges = nullptr;
     xxEndRenderPassSystem(commandEncoder, framebuffer, renderPass);
 }
 //------------------------------------------------------------------------------
 static void xxSetViewportRuntime(uint64_t commandEncoder, int x, int y, int width, int height, float minZ, float maxZ)
 {
     if (bindViewport.x == x && bindViewport.y == y && bindViewport.width == width && bindViewport.height == height && bindViewport.minZ == minZ && bindViewport.maxZ == maxZ)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindViewport = {x, y, width, height, minZ, maxZ};
     xxSetViewportSystem(commandEncoder, x, y, width, height, minZ, maxZ);
 }
@@ -71,7 +85,11 @@ static void xxSetViewportRuntime(uint64_t commandEncoder, int x, int y, int widt
 static void xxSetScissorRuntime(uint64_t commandEncoder, int x, int y, int width, int height)
 {
     if (bindScissor.x == x && bindScissor.y == y && bindScissor.width == width && bindScissor.height == height)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindScissor = {x, y, width, height};
     xxSetScissorSystem(commandEncoder, x, y, width, height);
 }
@@ -79,7 +97,11 @@ static void xxSetScissorRuntime(uint64_t commandEncoder, int x, int y, int width
 static void xxSetPipelineRuntime(uint64_t commandEncoder, uint64_t pipeline)
 {
     if (bindPipeline == pipeline)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindPipeline = pipeline;
     xxSetPipelineSystem(commandEncoder, pipeline);
 }
@@ -96,7 +118,11 @@ static void xxSetMeshBuffersRuntime(uint64_t commandEncoder, int count, const ui
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetMeshBuffersSystem(commandEncoder, count, buffers);
 }
 //------------------------------------------------------------------------------
@@ -112,7 +138,11 @@ static void xxSetVertexBuffersRuntime(uint64_t commandEncoder, int count, const
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetVertexBuffersSystem(commandEncoder, count, buffers, vertexAttribute);
 }
 //------------------------------------------------------------------------------
@@ -128,7 +158,11 @@ static void xxSetVertexTexturesRuntime(uint64_t commandEncoder, int count, const
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetVertexTexturesSystem(commandEncoder, count, textures);
 }
 //------------------------------------------------------------------------------
@@ -144,7 +178,11 @@ static void xxSetFragmentTexturesRuntime(uint64_t commandEncoder, int count, con
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetFragmentTexturesSystem(commandEncoder, count, textures);
 }
 //------------------------------------------------------------------------------
@@ -160,7 +198,11 @@ static void xxSetVertexSamplersRuntime(uint64_t commandEncoder, int count, const
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetVertexSamplersSystem(commandEncoder, count, samplers);
 }
 //------------------------------------------------------------------------------
@@ -176,14 +218,22 @@ static void xxSetFragmentSamplersRuntime(uint64_t commandEncoder, int count, con
         }
     }
     if (update == false)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     xxSetFragmentSamplersSystem(commandEncoder, count, samplers);
 }
 //------------------------------------------------------------------------------
 static void xxSetMeshConstantBufferRuntime(uint64_t commandEncoder, uint64_t buffer, int size)
 {
     if (bindMeshConstantBuffer == buffer)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindMeshConstantBuffer = buffer;
     xxSetMeshConstantBufferSystem(commandEncoder, buffer, size);
 }
@@ -191,7 +241,11 @@ static void xxSetMeshConstantBufferRuntime(uint64_t commandEncoder, uint64_t buf
 static void xxSetVertexConstantBufferRuntime(uint64_t commandEncoder, uint64_t buffer, int size)
 {
     if (bindVertexConstantBuffer == buffer)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindVertexConstantBuffer = buffer;
     xxSetVertexConstantBufferSystem(commandEncoder, buffer, size);
 }
@@ -199,10 +253,46 @@ static void xxSetVertexConstantBufferRuntime(uint64_t commandEncoder, uint64_t b
 static void xxSetFragmentConstantBufferRuntime(uint64_t commandEncoder, uint64_t buffer, int size)
 {
     if (bindFragmentConstantBuffer == buffer)
+    {
+        Binding::ElidedCount++;
         return;
+    }
+    Binding::IssuedCount++;
     bindFragmentConstantBuffer = buffer;
     xxSetFragmentConstantBufferSystem(commandEncoder, buffer, size);
 }
+//------------------------------------------------------------------------------
+static void xxDrawRuntime(uint64_t commandEncoder, int vertexCount, int instanceCount, int firstVertex, int firstInstance)
+{
+    if (Binding::InstanceCount > 1)
+    {
+        instanceCount = Binding::InstanceCount;
+        Binding::InstanceCount = 0;
+    }
+    xxDrawSystem(commandEncoder, vertexCount, instanceCount, firstVertex, firstInstance);
+}
+//------------------------------------------------------------------------------
+static void xxDrawIndexedRuntime(uint64_t commandEncoder, uint64_t indexBuffer, int indexCount, int vertexCount, int instanceCount, int firstIndex, int vertexOffset, int firstInstance)
+{
+    if (Binding::InstanceCount > 1)
+    {
+        instanceCount = Binding::InstanceCount;
+        Binding::InstanceCount = 0;
+    }
+    if (Binding::IndexRanges)
+    {
+        int const* ranges = Binding::IndexRanges;
+        int count = Binding::IndexRangeCount;
+        Binding::IndexRanges = nullptr;
+        Binding::IndexRangeCount = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            xxDrawIndexedSystem(commandEncoder, indexBuffer, ranges[i * 2 + 1], vertexCount, instanceCount, firstIndex + ranges[i * 2], vertexOffset, firstInstance);
+        }
+        return;
+    }
+    xxDrawIndexedSystem(commandEncoder, indexBuffer, indexCount, vertexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+}
 //==============================================================================
 void Binding::Initialize()
 {
@@ -221,12 +311,16 @@ void Binding::Initialize()
     xxSetMeshConstantBufferSystem = xxSetMeshConstantBuffer;
     xxSetVertexConstantBufferSystem = xxSetVertexConstantBuffer;
     xxSetFragmentConstantBufferSystem = xxSetFragmentConstantBuffer;
+    xxDrawSystem = xxDraw;
+    xxDrawIndexedSystem = xxDrawIndexed;
     xxEndRenderPass = xxEndRenderPassRuntime;
     xxSetViewport = xxSetViewportRuntime;
     xxSetScissor = xxSetScissorRuntime;
     xxSetPipeline = xxSetPipelineRuntime;
     xxSetMeshBuffers = xxSetMeshBuffersRuntime;
     xxSetVertexBuffers = xxSetVertexBuffersRuntime;
+    xxDraw = xxDrawRuntime;
+    xxDrawIndexed = xxDrawIndexedRuntime;
 #if defined(xxMACOS) || defined(xxWINDOWS)
     if (xxGetInstanceName == xxGetInstanceNameGlide)
         return;
@@ -261,6 +355,8 @@ void Binding::Shutdown()
     xxSetMeshConstantBuffer = xxSetMeshConstantBufferSystem;
     xxSetVertexConstantBuffer = xxSetVertexConstantBufferSystem;
     xxSetFragmentConstantBuffer = xxSetFragmentConstantBufferSystem;
+    xxDraw = xxDrawSystem;
+    xxDrawIndexed = xxDrawIndexedSystem;
     xxEndRenderPassSystem = nullptr;
     xxSetViewportSystem = nullptr;
     xxSetScissorSystem = nullptr;
@@ -274,5 +370,7 @@ void Binding::Shutdown()
     xxSetMeshConstantBufferSystem = nullptr;
     xxSetVertexConstantBufferSystem = nullptr;
     xxSetFragmentConstantBufferSystem = nullptr;
+    xxDrawSystem = nullptr;
+    xxDrawIndexedSystem = nullptr;
 }
 //==============================================================================
@@ -12,4 +12,10 @@ struct RuntimeAPI Binding
 {
     static void Initialize();
     static void Shutdown();
+
+    static size_t IssuedCount;
+    static size_t ElidedCount;
+    static int InstanceCount;
+    static int IndexRangeCount;
+    static int const* IndexRanges;
 };
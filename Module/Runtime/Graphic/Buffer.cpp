@@ -6,26 +6,82 @@
 //==============================================================================
 #include "Runtime.h"
 #include <deque>
+#include <unordered_map>
 #include <xxGraphicPlus/xxMesh.h>
+#include "Resource.h"
 #include "Buffer.h"
 
 //==============================================================================
 struct DestroyBuffer { size_t counter; uint64_t device; uint64_t buffer; };
 static size_t Counter = 0;
 static std::deque<DestroyBuffer> destroyBuffers;
+static std::unordered_map<uint64_t, size_t> bufferSizes;
 //------------------------------------------------------------------------------
-static void (*xxDestroyBufferSystem)(uint64_t device, uint64_t buffer);
+static uint64_t (*xxCreateConstantBufferSystem)(uint64_t device, int size);
+static uint64_t (*xxCreateIndexBufferSystem)(uint64_t device, int size, int bits);
+static uint64_t (*xxCreateVertexBufferSystem)(uint64_t device, int size, uint64_t vertexAttribute);
+static void     (*xxDestroyBufferSystem)(uint64_t device, uint64_t buffer);
+//------------------------------------------------------------------------------
+static uint64_t CreateBuffer(uint64_t buffer, int size)
+{
+    if (buffer != 0)
+    {
+        Resource::Statistic& statistic = Resource::Current[Resource::BUFFER];
+        statistic.count++;
+        statistic.bytes += size;
+        statistic.created++;
+        bufferSizes[buffer] = size;
+    }
+    return buffer;
+}
+//------------------------------------------------------------------------------
+static void ReleaseBuffer(DestroyBuffer const& destroyBuffer)
+{
+    Resource::Statistic& statistic = Resource::Current[Resource::BUFFER];
+    auto it = bufferSizes.find(destroyBuffer.buffer);
+    if (it != bufferSizes.end())
+    {
+        statistic.count--;
+        statistic.bytes -= (*it).second;
+        bufferSizes.erase(it);
+    }
+    xxDestroyBufferSystem(destroyBuffer.device, destroyBuffer.buffer);
+}
+//------------------------------------------------------------------------------
+static uint64_t xxCreateConstantBufferRuntime(uint64_t device, int size)
+{
+    return CreateBuffer(xxCreateConstantBufferSystem(device, size), size);
+}
+//------------------------------------------------------------------------------
+static uint64_t xxCreateIndexBufferRuntime(uint64_t device, int size, int bits)
+{
+    return CreateBuffer(xxCreateIndexBufferSystem(device, size, bits), size);
+}
+//------------------------------------------------------------------------------
+static uint64_t xxCreateVertexBufferRuntime(uint64_t device, int size, uint64_t vertexAttribute)
+{
+    return CreateBuffer(xxCreateVertexBufferSystem(device, size, vertexAttribute), size);
+}
 //------------------------------------------------------------------------------
 static void xxDestroyBufferRuntime(uint64_t device, uint64_t buffer)
 {
+    if (buffer == 0)
+        return;
     destroyBuffers.push_back({ Counter + 4, device, buffer });
+    Resource::Current[Resource::BUFFER].pending = destroyBuffers.size();
 }
 //==============================================================================
 void Buffer::Initialize()
 {
     if (xxDestroyBufferSystem)
         return;
+    xxCreateConstantBufferSystem = xxCreateConstantBuffer;
+    xxCreateIndexBufferSystem = xxCreateIndexBuffer;
+    xxCreateVertexBufferSystem = xxCreateVertexBuffer;
     xxDestroyBufferSystem = xxDestroyBuffer;
+    xxCreateConstantBuffer = xxCreateConstantBufferRuntime;
+    xxCreateIndexBuffer = xxCreateIndexBufferRuntime;
+    xxCreateVertexBuffer = xxCreateVertexBufferRuntime;
     xxDestroyBuffer = xxDestroyBufferRuntime;
 
     xxMesh::TransitionBufferCount(1);
@@ -38,10 +94,11 @@ void Buffer::Update()
     {
         auto& destroyBuffer = destroyBuffers.front();
         if (destroyBuffer.counter > Counter)
-            return;
-        xxDestroyBufferSystem(destroyBuffer.device, destroyBuffer.buffer);
+            break;
+        ReleaseBuffer(destroyBuffer);
         destroyBuffers.pop_front();
     }
+    Resource::Current[Resource::BUFFER].pending = destroyBuffers.size();
 }
 //------------------------------------------------------------------------------
 void Buffer::Shutdown()
@@ -51,10 +108,18 @@ void Buffer::Shutdown()
     while (destroyBuffers.empty() == false)
     {
         auto& destroyBuffer = destroyBuffers.front();
-        xxDestroyBufferSystem(destroyBuffer.device, destroyBuffer.buffer);
+        ReleaseBuffer(destroyBuffer);
         destroyBuffers.pop_front();
     }
+    bufferSizes.clear();
+    Resource::Current[Resource::BUFFER] = {};
+    xxCreateConstantBuffer = xxCreateConstantBufferSystem;
+    xxCreateIndexBuffer = xxCreateIndexBufferSystem;
+    xxCreateVertexBuffer = xxCreateVertexBufferSystem;
     xxDestroyBuffer = xxDestroyBufferSystem;
+    xxCreateConstantBufferSystem = nullptr;
+    xxCreateIndexBufferSystem = nullptr;
+    xxCreateVertexBufferSystem = nullptr;
     xxDestroyBufferSystem = nullptr;
 }
 //==============================================================================
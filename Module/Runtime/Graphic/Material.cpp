@@ -9,11 +9,30 @@
 #include <xxGraphicPlus/xxMesh.h>
 #include <xxGraphicPlus/xxNode.h>
 #include <xxGraphicPlus/xxTexture.h>
+#include "Tools/LightTools.h"
+#include "Tools/MeshletTools.h"
+#include "Tools/SkinningTools.h"
+#include "Binding.h"
 #include "Material.h"
+#include "Texture.h"
 
 //==============================================================================
 //  Material
 //==============================================================================
+static xxNode* const* instanceNodes = nullptr;
+static int instanceCount = 0;
+static bool instanceShader = false;
+static bool instanceDrawn = false;
+//------------------------------------------------------------------------------
+static xxVector4* MapAlternateBuffer(uint64_t device, uint64_t const (&buffers)[2], int& index)
+{
+    // Alternate the buffers so the binding filter never elides a refreshed constant
+    xxVector4* vector = reinterpret_cast<xxVector4*>(xxMapBuffer(device, buffers[index ^ 1]));
+    if (vector)
+        index ^= 1;
+    return vector;
+}
+//------------------------------------------------------------------------------
 struct MaterialSelector
 {
     std::string& shader;
@@ -130,7 +149,24 @@ struct MaterialSelector
 void Material::Invalidate()
 {
     xxDestroyShader(m_device, m_meshShader);
+    for (Instance const& instance : m_instances)
+    {
+        xxDestroyShader(m_device, instance.vertexShader);
+        xxDestroyPipeline(instance.pipeline);
+        xxDestroyBuffer(m_device, instance.constants[0]);
+        xxDestroyBuffer(m_device, instance.constants[1]);
+    }
+    xxDestroyBuffer(m_device, m_lightConstants[0]);
+    xxDestroyBuffer(m_device, m_lightConstants[1]);
     m_meshShader = 0;
+    m_instances.clear();
+    m_instanceCurrent = 0;
+    m_boneCount = 0;
+    m_lightConstants[0] = 0;
+    m_lightConstants[1] = 0;
+    m_lightConstantSize = 0;
+    m_lightSerial = 0;
+    m_clusterLighting = false;
     return xxMaterial::Invalidate();
 }
 //------------------------------------------------------------------------------
@@ -138,16 +174,39 @@ void Material::Draw(xxDrawData const& data) const
 {
     auto* constantData = data.constantData;
 
-    xxSetPipeline(data.commandEncoder, constantData->pipeline);
-    if (constantData->meshConstant)
+    Binding::IndexRanges = nullptr;
+    Binding::IndexRangeCount = 0;
+    if (instanceCount > 1 && UpdateInstance(data))
     {
-        xxSetMeshConstantBuffer(data.commandEncoder, constantData->meshConstant, constantData->meshConstantSize);
+        Instance const& instance = m_instances[m_instanceCurrent];
+        xxSetPipeline(data.commandEncoder, instance.pipeline);
+        xxSetVertexConstantBuffer(data.commandEncoder, instance.constants[instance.constantIndex], instance.constantSize);
+        Binding::InstanceCount = instanceCount;
+        instanceDrawn = true;
     }
-    if (constantData->vertexConstant)
+    else
     {
-        xxSetVertexConstantBuffer(data.commandEncoder, constantData->vertexConstant, constantData->vertexConstantSize);
+        xxSetPipeline(data.commandEncoder, constantData->pipeline);
+        if (constantData->meshConstant)
+        {
+            xxSetMeshConstantBuffer(data.commandEncoder, constantData->meshConstant, constantData->meshConstantSize);
+        }
+        if (constantData->vertexConstant)
+        {
+            xxSetVertexConstantBuffer(data.commandEncoder, constantData->vertexConstant, constantData->vertexConstantSize);
+        }
+        if (m_meshShader == 0 && (BackfaceCulling || FrustumCulling) && MeshletTools::Available(data.mesh))
+        {
+            xxMatrix4x2 const* frustum = FrustumCulling ? data.frustum : nullptr;
+            xxVector3 const* eye = BackfaceCulling && data.camera ? &data.camera->Location : nullptr;
+            Binding::IndexRanges = MeshletTools::Cull(data.mesh, data.node->WorldMatrix, frustum, eye, Binding::IndexRangeCount);
+        }
     }
-    if (constantData->fragmentConstant)
+    if (m_clusterLighting && UpdateClusterLighting(data))
+    {
+        xxSetFragmentConstantBuffer(data.commandEncoder, m_lightConstants[m_lightConstantIndex], m_lightConstantSize);
+    }
+    else if (constantData->fragmentConstant)
     {
         xxSetFragmentConstantBuffer(data.commandEncoder, constantData->fragmentConstant, constantData->fragmentConstantSize);
     }
@@ -163,7 +222,7 @@ void Material::Draw(xxDrawData const& data) const
         if (i >= Textures.size())
             continue;
         xxTexturePtr const& texture = Textures[i];
-        texture->Update(data.device);
+        Texture::Update(texture, data.device);
         textures[i] = texture->Texture;
         samplers[i] = texture->Sampler;
         textureCount = i + 1;
@@ -182,6 +241,26 @@ void Material::CreatePipeline(xxDrawData const& data)
     if (vertexAttribute == 0)
         return;
 
+    // Software skinning changes the vertex layout of the meshes drawn with the material
+    if (m_pipeline && m_vertexAttribute != vertexAttribute)
+    {
+        Invalidate();
+    }
+    m_vertexAttribute = vertexAttribute;
+
+    // The bone block follows the largest skeleton drawn with the material
+    int boneCount = 0;
+    if (mesh->Skinning)
+    {
+        int count = (int(data.node->Bones.size()) + 15) & ~15;
+        boneCount = std::min(std::max(count, 16), SkinningTools::GetBoneLimit());
+    }
+    if (m_pipeline && boneCount > m_boneCount)
+    {
+        Invalidate();
+    }
+    m_boneCount = std::max(m_boneCount, boneCount);
+
     if (m_pipeline == 0)
     {
         if (m_blendState == 0)
@@ -210,6 +289,7 @@ void Material::CreatePipeline(xxDrawData const& data)
         }
         if (m_meshShader == 0 && m_vertexShader == 0 && m_fragmentShader == 0)
         {
+            m_clusterLighting = Lighting && mesh->NormalCount > 0 && LightTools::Available();
             if (m_meshShader == 0 && mesh->Count[xxMesh::STORAGE0] && mesh->Count[xxMesh::STORAGE1] && mesh->Count[xxMesh::STORAGE2])
             {
                 m_meshShader = xxCreateMeshShader(m_device, GetShader(data, 'mesh').c_str());
@@ -235,6 +315,28 @@ void Material::CreateConstant(xxDrawData const& data) const
 {
     auto* constantData = data.constantData;
 
+    // Constants are sized for the pipeline, they are recreated when the pipeline is rebuilt,
+    // a rebuilt pipeline may reuse the previous handle so the sizes are compared as well
+    bool rebuild = constantData->pipeline != m_pipeline;
+    if (rebuild == false && constantData->meshConstant && constantData->meshConstantSize != GetMeshConstantSize(data))
+        rebuild = true;
+    if (rebuild == false && constantData->vertexConstant && constantData->vertexConstantSize != GetVertexConstantSize(data))
+        rebuild = true;
+    if (rebuild == false && constantData->fragmentConstant && constantData->fragmentConstantSize != GetFragmentConstantSize(data))
+        rebuild = true;
+    if (rebuild)
+    {
+        xxDestroyBuffer(m_device, constantData->meshConstant);
+        xxDestroyBuffer(m_device, constantData->vertexConstant);
+        xxDestroyBuffer(m_device, constantData->fragmentConstant);
+        constantData->meshConstant = 0;
+        constantData->vertexConstant = 0;
+        constantData->fragmentConstant = 0;
+        constantData->meshConstantSize = 0;
+        constantData->vertexConstantSize = 0;
+        constantData->fragmentConstantSize = 0;
+    }
+
     if (constantData->meshConstant == 0 &&constantData->vertexConstant == 0 && constantData->fragmentConstant == 0)
     {
         constantData->device = data.device;
@@ -255,7 +357,7 @@ void Material::CreateConstant(xxDrawData const& data) const
                 constantData->vertexConstant = xxCreateConstantBuffer(m_device, constantData->vertexConstantSize);
             }
         }
-        if (m_fragmentShader && constantData->fragmentConstant == 0)
+        if (m_fragmentShader && constantData->fragmentConstant == 0 && m_clusterLighting == false)
         {
             constantData->fragmentConstantSize = GetFragmentConstantSize(data);
             if (constantData->fragmentConstantSize > 0)
@@ -305,6 +407,89 @@ void Material::UpdateConstant(xxDrawData const& data) const
     }
 }
 //------------------------------------------------------------------------------
+bool Material::UpdateInstance(xxDrawData const& data) const
+{
+    xxMesh* mesh = data.mesh;
+    if (m_pipeline == 0 || m_meshShader || mesh->Skinning)
+        return false;
+
+    // Meshes sharing the material may have different vertex layouts
+    uint64_t vertexAttribute = mesh->GetVertexAttribute();
+    auto& instances = const_cast<std::vector<Instance>&>(m_instances);
+    size_t current = 0;
+    while (current < instances.size() && instances[current].vertexAttribute != vertexAttribute)
+        current++;
+    if (current == instances.size())
+    {
+        Instance instance;
+        instance.vertexAttribute = vertexAttribute;
+        uint16_t meshTextureSlot = m_meshTextureSlot;
+        uint16_t vertexTextureSlot = m_vertexTextureSlot;
+        uint16_t fragmentTextureSlot = m_fragmentTextureSlot;
+        instanceShader = true;
+        instance.vertexShader = xxCreateVertexShader(m_device, GetShader(data, 'vert').c_str(), vertexAttribute);
+        instance.constantSize = GetVertexConstantSize(data);
+        instanceShader = false;
+        const_cast<uint16_t&>(m_meshTextureSlot) = meshTextureSlot;
+        const_cast<uint16_t&>(m_vertexTextureSlot) = vertexTextureSlot;
+        const_cast<uint16_t&>(m_fragmentTextureSlot) = fragmentTextureSlot;
+        if (instance.vertexShader)
+        {
+            instance.constants[0] = xxCreateConstantBuffer(m_device, instance.constantSize);
+            instance.constants[1] = xxCreateConstantBuffer(m_device, instance.constantSize);
+            instance.pipeline = xxCreatePipeline(m_device, m_renderPass, m_blendState, m_depthStencilState, m_rasterizerState, vertexAttribute, 0, instance.vertexShader, m_fragmentShader);
+        }
+        instances.push_back(instance);
+    }
+    Instance& instance = instances[current];
+    if (instance.pipeline == 0 || instance.constants[0] == 0 || instance.constants[1] == 0)
+        return false;
+
+    xxVector4* vector = MapAlternateBuffer(m_device, instance.constants, instance.constantIndex);
+    if (vector == nullptr)
+        return false;
+    int size = instance.constantSize;
+    instanceShader = true;
+    UpdateWorldViewProjectionConstant(data, size, &vector);
+    UpdateBlendingConstant(data, size, &vector);
+    UpdateLightingConstant(data, size, &vector);
+    instanceShader = false;
+    xxUnmapBuffer(m_device, instance.constants[instance.constantIndex]);
+    const_cast<size_t&>(m_instanceCurrent) = current;
+    return true;
+}
+//------------------------------------------------------------------------------
+bool Material::UpdateClusterLighting(xxDrawData const& data) const
+{
+    uint32_t serial = LightTools::GetSerial();
+    if (m_lightConstants[0] && m_lightConstants[1] && m_lightSerial == serial)
+        return true;
+
+    // Fragment constants only depend on the material and the camera, so every draw shares them
+    if (m_lightConstants[0] == 0 || m_lightConstants[1] == 0)
+    {
+        int size = GetFragmentConstantSize(data);
+        const_cast<int&>(m_lightConstantSize) = size;
+        if (m_lightConstants[0] == 0)
+            const_cast<uint64_t&>(m_lightConstants[0]) = xxCreateConstantBuffer(m_device, size);
+        if (m_lightConstants[1] == 0)
+            const_cast<uint64_t&>(m_lightConstants[1]) = xxCreateConstantBuffer(m_device, size);
+        if (m_lightConstants[0] == 0 || m_lightConstants[1] == 0)
+            return false;
+    }
+
+    xxVector4* vector = MapAlternateBuffer(m_device, m_lightConstants, const_cast<int&>(m_lightConstantIndex));
+    if (vector == nullptr)
+        return false;
+    int size = m_lightConstantSize;
+    UpdateAlphaTestingConstant(data, size, &vector);
+    UpdateLightingConstant(data, size, &vector);
+    UpdateClusterLightingConstant(data, size, &vector);
+    xxUnmapBuffer(m_device, m_lightConstants[m_lightConstantIndex]);
+    const_cast<uint32_t&>(m_lightSerial) = serial;
+    return true;
+}
+//------------------------------------------------------------------------------
 std::string Material::GetShader(xxDrawData const& data, int type) const
 {
     xxMesh* mesh = data.mesh;
@@ -355,6 +540,8 @@ std::string Material::GetShader(xxDrawData const& data, int type) const
         break;
     case 'vert':
         shader += define("SHADER_UNIFORM", GetVertexConstantSize(data) / sizeof(xxVector4));
+        shader += define("SHADER_INSTANCE", instanceShader ? INSTANCE_MAX : 0);
+        shader += define("SHADER_BONE", m_boneCount);
         shader += define("SHADER_SKINNING", mesh->Skinning ? 1 : 0);
         shader += define("SHADER_OPACITY", Blending ? 1 : 0);
         ShaderDefault(data, s);
@@ -366,6 +553,10 @@ std::string Material::GetShader(xxDrawData const& data, int type) const
     case 'frag':
         shader += define("SHADER_UNIFORM", GetFragmentConstantSize(data) / sizeof(xxVector4));
         shader += define("SHADER_ALPHATEST", AlphaTest ? 1 : 0);
+        shader += define("LIGHT_MAX", LightTools::LIGHT_MAX);
+        shader += define("CLUSTER_X", LightTools::CLUSTER_X);
+        shader += define("CLUSTER_Y", LightTools::CLUSTER_Y);
+        shader += define("CLUSTER_Z", LightTools::CLUSTER_Z);
         ShaderDefault(data, s);
         ShaderConstant(data, s);
         ShaderVarying(data, s);
@@ -415,6 +606,7 @@ int Material::GetFragmentConstantSize(xxDrawData const& data) const
     int size = 0;
     UpdateAlphaTestingConstant(data, size);
     UpdateLightingConstant(data, size);
+    UpdateClusterLightingConstant(data, size);
     return size;
 }
 //------------------------------------------------------------------------------
@@ -457,6 +649,8 @@ void Material::ShaderDefault(xxDrawData const& data, struct MaterialSelector& s)
         macro("SHADER_COLOR", "1");
         macro("SHADER_TEXTURE", "1");
         macro("SHADER_UNIFORM", "12");
+        macro("SHADER_INSTANCE", "0");
+        macro("SHADER_BONE", "0");
         macro("SHADER_ALPHATEST", "0");
         macro("SHADER_OPACITY", "0");
         macro("SHADER_LIGHTING", "0");
@@ -478,6 +672,11 @@ void Material::ShaderDefault(xxDrawData const& data, struct MaterialSelector& s)
     {
         macro("mul(a, b)", "(b * a)", false);
     }
+    if (s.language == 'MSL1' || s.language == 'MSL2')
+    {
+        macro("asuint(x)", "as_type<uint>(x)", false);
+        macro("firstbitlow(x)", "ctz(x)", false);
+    }
 }
 //------------------------------------------------------------------------------
 void Material::ShaderAttribute(xxDrawData const& data, struct MaterialSelector& s) const
@@ -577,6 +776,7 @@ void Material::ShaderVarying(xxDrawData const& data, struct MaterialSelector& s)
     int normal = mesh->NormalCount;
     int color = mesh->ColorCount;
     int texture = mesh->TextureCount;
+    bool position = Specular || m_clusterLighting;
 
     //                       GLSL                               HLSL                                 MSL
     s.GHM(true,              "",                                "struct Varying",                    "struct Varying"                );
@@ -584,7 +784,7 @@ void Material::ShaderVarying(xxDrawData const& data, struct MaterialSelector& s)
     s.GHM(true,              "",                                "float4 Position : SV_POSITION",     "float4 Position [[position]];" );
     s.GHM(color || Lighting, "varying vec4 varyColor;",         "float4 Color : COLOR;",             "float4 Color;"                 );
     s.GHM(texture > 0,       "varying vec2 varyUV0;",           "float2 UV0 : TEXCOORD0;",           "float2 UV0;"                   );
-    s.GHM(Specular,          "varying vec3 varyWorldPosition;", "float3 WorldPosition : TEXCOORD4;", "float3 WorldPosition;"         );
+    s.GHM(position,          "varying vec3 varyWorldPosition;", "float3 WorldPosition : TEXCOORD4;", "float3 WorldPosition;"         );
     s.GHM(normal > 0,        "varying vec3 varyWorldNormal;",   "float3 WorldNormal : TEXCOORD5;",   "float3 WorldNormal;"           );
     s.GHM(normal > 1,        "varying vec3 varyWorldTangent;",  "float3 WorldTangent : TEXCOORD6;",  "float3 WorldTangent;"          );
     s.GHM(normal > 2,        "varying vec3 varyWorldBinormal;", "float3 WorldBinormal : TEXCOORD7;", "float3 WorldBinormal;"         );
@@ -598,6 +798,7 @@ void Material::ShaderMesh(xxDrawData const& data, struct MaterialSelector& s) co
     int normal = mesh->NormalCount;
     int color = mesh->ColorCount;
     int texture = mesh->TextureCount;
+    bool position = Lighting && (Specular || m_clusterLighting);
     int size = 0;
 
     //             HLSL                                MSL                                                        MSL Arugment
@@ -661,7 +862,7 @@ void Material::ShaderMesh(xxDrawData const& data, struct MaterialSelector& s) co
     s.HM(true,                   "vary[gtid].Position = screenPosition;",         "vary.Position = screenPosition;"         );
     s.HM(Lighting || color,      "vary[gtid].Color = color;",                     "vary.Color = color;"                     );
     s.HM(texture > 0,            "vary[gtid].UV0 = attrUV0;",                     "vary.UV0 = attrUV0;"                     );
-    s.HM(Lighting && Specular,   "vary[gtid].WorldPosition = worldPosition.xyz;", "vary.WorldPosition = worldPosition.xyz;" );
+    s.HM(position,               "vary[gtid].WorldPosition = worldPosition.xyz;", "vary.WorldPosition = worldPosition.xyz;" );
     s.HM(Lighting && normal > 0, "vary[gtid].WorldNormal = worldNormal;",         "vary.WorldNormal = worldNormal;"         );
     s.HM(Lighting && normal > 1, "vary[gtid].WorldTangent = worldTangent;",       "vary.WorldTangent = worldTangent;"       );
     s.HM(Lighting && normal > 2, "vary[gtid].WorldBinormal = worldBinormal;",     "vary.WorldBinormal = worldBinormal;"     );
@@ -676,11 +877,14 @@ void Material::ShaderVertex(xxDrawData const& data, struct MaterialSelector& s)
     int normal = mesh->NormalCount;
     int color = mesh->ColorCount;
     int texture = mesh->TextureCount;
+    bool position = Lighting && (Specular || m_clusterLighting);
     int size = 0;
 
     //          GLSL                       HLSL                            MSL
     s.GHM(true, "",                        "",                             "vertex"                                    );
-    s.GHM(true, "void main()",             "Varying Main(Attribute attr)", "Varying Main(Attribute attr [[stage_in]]," );
+    s.GHM(true, "void main()",             instanceShader ? "Varying Main(Attribute attr, uint instanceID : SV_InstanceID)"
+                                                          : "Varying Main(Attribute attr)", "Varying Main(Attribute attr [[stage_in]]," );
+    s.GHM(instanceShader, "",              "",                             "uint instanceID [[instance_id]],"          );
     s.GHM(true, "",                        "",                             "constant Uniform& uni [[buffer(0)]])"      );
     s.GHM(true, "{",                       "{",                            "{"                                         );
     s.GHM(true, "",                        "",                             "auto uniBuffer = uni.Buffer;"              );
@@ -708,7 +912,7 @@ void Material::ShaderVertex(xxDrawData const& data, struct MaterialSelector& s)
     s.GH(true,                   "gl_Position = screenPosition;",          "vary.Position = screenPosition;"         );
     s.GH(Lighting || color,      "varyColor = color;",                     "vary.Color = color;"                     );
     s.GH(texture > 0,            "varyUV0 = attrUV0;",                     "vary.UV0 = attrUV0;"                     );
-    s.GH(Lighting && Specular,   "varyWorldPosition = worldPosition.xyz;", "vary.WorldPosition = worldPosition.xyz;" );
+    s.GH(position,               "varyWorldPosition = worldPosition.xyz;", "vary.WorldPosition = worldPosition.xyz;" );
     s.GH(Lighting && normal > 0, "varyWorldNormal = worldNormal;",         "vary.WorldNormal = worldNormal;"         );
     s.GH(Lighting && normal > 1, "varyWorldTangent = worldTangent;",       "vary.WorldTangent = worldTangent;"       );
     s.GH(Lighting && normal > 2, "varyWorldBinormal = worldBinormal;",     "vary.WorldBinormal = worldBinormal;"     );
@@ -722,10 +926,12 @@ void Material::ShaderFragment(xxDrawData const& data, struct MaterialSelector& s
     int normal = mesh->NormalCount;
     int color = mesh->ColorCount;
     int texture = mesh->TextureCount;
+    bool position = Lighting && (Specular || m_clusterLighting);
     int size = 0;
 
     bool base = GetTexture(BASE) != nullptr;
     bool bump = GetTexture(BUMP) != nullptr;
+    bool single = base && GetTexture(BASE)->Format == "R8"_CC;
 
     //          GLSL                       HLSL                                  MSL
     s.GHM(true, "",                        "",                                   "fragment"                               );
@@ -743,7 +949,7 @@ void Material::ShaderFragment(xxDrawData const& data, struct MaterialSelector& s
     //                           GLSL                  HLSL / MSL
     s.GH(Lighting || color,      "",                   "float4 varyColor = vary.Color;"                 );
     s.GH(texture > 0,            "",                   "float2 varyUV0 = vary.UV0;"                     );
-    s.GH(Lighting && Specular,   "",                   "float3 varyWorldPosition = vary.WorldPosition;" );
+    s.GH(position,               "",                   "float3 varyWorldPosition = vary.WorldPosition;" );
     s.GH(Lighting && normal > 0, "",                   "float3 varyWorldNormal = vary.WorldNormal;"     );
     s.GH(Lighting && normal > 1, "",                   "float3 varyWorldTangent = vary.WorldTangent;"   );
     s.GH(Lighting && normal > 2, "",                   "float3 varyWorldBinormal = vary.WorldBinormal;" );
@@ -755,13 +961,15 @@ void Material::ShaderFragment(xxDrawData const& data, struct MaterialSelector& s
     s.GHMM(base, "",  "",  "auto BaseSampler = sam.BaseSampler;", "auto BaseSampler = uni.BaseSampler;" );
     s.GHMM(bump, "",  "",  "auto BumpSampler = sam.BumpSampler;", "auto BumpSampler = uni.BumpSampler;" );
 
-    //           GLSL                                         HLSL                                     HLSL10                                         MSL
-    s.GHHM(base, "color *= texture2D(BaseSampler, varyUV0);", "color *= tex2D(BaseSampler, varyUV0);", "color *= Base.Sample(BaseSampler, varyUV0);", "color *= Base.sample(BaseSampler, varyUV0);" );
-    s.GHHM(bump, "bump = texture2D(BumpSampler, varyUV0);",   "bump = tex2D(BumpSampler, varyUV0);",   "bump = Bump.Sample(BumpSampler, varyUV0);",   "bump = Bump.sample(BumpSampler, varyUV0);"   );
-    s.GHHM(bump, "bump = bump * 2.0 - 1.0;",                  "bump = bump * 2.0 - 1.0;",              "bump = bump * 2.0 - 1.0;",                    "bump = bump * 2.0 - 1.0;"                    );
+    //                     GLSL                                             HLSL                                         HLSL10                                             MSL
+    s.GHHM(base && !single, "color *= texture2D(BaseSampler, varyUV0);",     "color *= tex2D(BaseSampler, varyUV0);",     "color *= Base.Sample(BaseSampler, varyUV0);",     "color *= Base.sample(BaseSampler, varyUV0);"     );
+    s.GHHM(single,          "color.a *= texture2D(BaseSampler, varyUV0).r;", "color.a *= tex2D(BaseSampler, varyUV0).r;", "color.a *= Base.Sample(BaseSampler, varyUV0).r;", "color.a *= Base.sample(BaseSampler, varyUV0).r;" );
+    s.GHHM(bump,            "bump = texture2D(BumpSampler, varyUV0);",       "bump = tex2D(BumpSampler, varyUV0);",       "bump = Bump.Sample(BumpSampler, varyUV0);",       "bump = Bump.sample(BumpSampler, varyUV0);"       );
+    s.GHHM(bump,            "bump = bump * 2.0 - 1.0;",                      "bump = bump * 2.0 - 1.0;",                  "bump = bump * 2.0 - 1.0;",                        "bump = bump * 2.0 - 1.0;"                        );
 
     UpdateAlphaTestingConstant(data, size, nullptr, &s);
     UpdateLightingConstant(data, size, nullptr, &s);
+    UpdateClusterLightingConstant(data, size, nullptr, &s);
 
     //         GLSL                     HLSL / MSL
     s.GH(true, "gl_FragColor = color;", "return color;" );
@@ -816,6 +1024,54 @@ void Material::UpdateBlendingConstant(xxDrawData const& data, int& size, xxVecto
     }
 }
 //------------------------------------------------------------------------------
+void Material::UpdateClusterLightingConstant(xxDrawData const& data, int& size, xxVector4** pointer, struct MaterialSelector* s) const
+{
+    if (m_clusterLighting == false)
+        return;
+    if (pointer == nullptr)
+    {
+        size += LightTools::CONSTANT_COUNT * sizeof(xxVector4);
+    }
+    if (size >= LightTools::CONSTANT_COUNT * sizeof(xxVector4) && pointer)
+    {
+        xxVector4* vector = (*pointer);
+        size -= LightTools::CONSTANT_COUNT * sizeof(xxVector4);
+        (*pointer) += LightTools::CONSTANT_COUNT;
+
+        memcpy(vector, LightTools::GetConstant(), LightTools::CONSTANT_COUNT * sizeof(xxVector4));
+    }
+    if (s)
+    {
+        (*s)(true, "float4 clusterRight = uniBuffer[uniIndex++];"                                                                   );
+        (*s)(true, "float4 clusterUp = uniBuffer[uniIndex++];"                                                                      );
+        (*s)(true, "float4 clusterFront = uniBuffer[uniIndex++];"                                                                   );
+        (*s)(true, "float4 clusterScale = uniBuffer[uniIndex++];"                                                                   );
+        (*s)(true, "float3 clusterVector = varyWorldPosition - cameraPosition;"                                                     );
+        (*s)(true, "float clusterDepth = max(dot(clusterVector, clusterFront.xyz), clusterFront.w);"                                );
+        (*s)(true, "int clusterX = clamp(int(dot(clusterVector, clusterRight.xyz) / clusterDepth * clusterRight.w + clusterScale.x), 0, CLUSTER_X - 1);" );
+        (*s)(true, "int clusterY = clamp(int(dot(clusterVector, clusterUp.xyz) / clusterDepth * clusterUp.w + clusterScale.y), 0, CLUSTER_Y - 1);"       );
+        (*s)(true, "int clusterZ = clamp(int(log(clusterDepth) * clusterScale.z + clusterScale.w), 0, CLUSTER_Z - 1);"              );
+        (*s)(true, "int cluster = (clusterZ * CLUSTER_Y + clusterY) * CLUSTER_X + clusterX;"                                        );
+        (*s)(true, "uint clusterMask = asuint(uniBuffer[uniIndex + LIGHT_MAX * 3 + (cluster >> 2)][cluster & 3]);"                  );
+        (*s)(true, "float3 clusterColor = float3(0.0, 0.0, 0.0);"                                                                   );
+        (*s)(true, "while (clusterMask != 0)"                                                                                       );
+        (*s)(true, "{"                                                                                                              );
+        (*s)(true, "int lightIndex = uniIndex + int(firstbitlow(clusterMask)) * 3;"                                                 );
+        (*s)(true, "clusterMask &= clusterMask - 1;"                                                                                );
+        (*s)(true, "float4 pointPosition = uniBuffer[lightIndex + 0];"                                                              );
+        (*s)(true, "float4 pointColor = uniBuffer[lightIndex + 1];"                                                                 );
+        (*s)(true, "float4 pointDirection = uniBuffer[lightIndex + 2];"                                                             );
+        (*s)(true, "float3 pointVector = pointPosition.xyz - varyWorldPosition;"                                                    );
+        (*s)(true, "float3 pointL = pointVector / max(length(pointVector), 0.0001);"                                                );
+        (*s)(true, "float pointFalloff = saturate(1.0 - length(pointVector) * pointPosition.w);"                                    );
+        (*s)(true, "float pointCone = saturate(dot(-pointL, pointDirection.xyz) * pointColor.w + pointDirection.w);"                );
+        (*s)(true, "clusterColor += pointColor.rgb * (max(dot(N, pointL), 0.0) * pointFalloff * pointFalloff * pointCone);"         );
+        (*s)(true, "}"                                                                                                              );
+        (*s)(true, "color.rgb += diffuseColor * clusterColor;"                                                                      );
+        (*s)(true, "uniIndex += LIGHT_MAX * 3 + CLUSTER_X * CLUSTER_Y * CLUSTER_Z / 4;"                                             );
+    }
+}
+//------------------------------------------------------------------------------
 void Material::UpdateCullingConstant(xxDrawData const& data, int& size, xxVector4** pointer, struct MaterialSelector* s) const
 {
     if (BackfaceCulling == false && FrustumCulling == false)
@@ -960,17 +1216,19 @@ void Material::UpdateSkinningConstant(xxDrawData const& data, int& size, xxVecto
         return;
     if (pointer == nullptr)
     {
-        size += 75 * sizeof(xxMatrix4x3);
+        size += m_boneCount * sizeof(xxMatrix4x3);
     }
-    if (size >= 75 * sizeof(xxMatrix4x3) && pointer)
+    if (size >= m_boneCount * sizeof(xxMatrix4x3) && pointer)
     {
         xxMatrix4x3* boneMatrix = reinterpret_cast<xxMatrix4x3*>(*pointer);
-        size -= 75 * sizeof(xxMatrix4x3);
-        (*pointer) += 75 * 3;
+        size -= m_boneCount * sizeof(xxMatrix4x3);
+        (*pointer) += m_boneCount * 3;
 
-        for (auto const& data : data.node->Bones)
+        auto* palette = SkinningTools::GetPalette(data.node);
+        if (palette)
         {
-            (*boneMatrix++) = xxMatrix4x3::FromMatrix4(data.boneMatrix);
+            size_t count = std::min(palette->matrices.size(), size_t(m_boneCount));
+            memcpy(boneMatrix, palette->matrices.data(), count * sizeof(xxMatrix4x3));
         }
     }
     if (s)
@@ -986,12 +1244,17 @@ void Material::UpdateSkinningConstant(xxDrawData const& data, int& size, xxVecto
         (*s)(true, "world[3][3] = 1.0;"                                                                                                                                );
         (*s)(true, "worldPosition = mul(float4(attrPosition, 1.0), world);"                                                                                            );
         (*s)(true, "screenPosition = mul(mul(worldPosition, view), projection);"                                                                                       );
-        (*s)(true, "uniIndex += 75 * 3;"                                                                                                                               );
+        (*s)(true, "uniIndex += SHADER_BONE * 3;"                                                                                                                      );
     }
 }
 //------------------------------------------------------------------------------
 void Material::UpdateWorldViewProjectionConstant(xxDrawData const& data, int& size, xxVector4** pointer, struct MaterialSelector* s) const
 {
+    if (instanceShader)
+    {
+        UpdateInstanceConstant(data, size, pointer, s);
+        return;
+    }
     if (pointer == nullptr)
     {
         size += 3 * sizeof(xxMatrix4x4);
@@ -1026,6 +1289,90 @@ void Material::UpdateWorldViewProjectionConstant(xxDrawData const& data, int& si
     }
 }
 //------------------------------------------------------------------------------
+void Material::UpdateInstanceConstant(xxDrawData const& data, int& size, xxVector4** pointer, struct MaterialSelector* s) const
+{
+    if (pointer == nullptr)
+    {
+        size += (2 + INSTANCE_MAX) * sizeof(xxMatrix4x4);
+    }
+    if (size >= (2 + INSTANCE_MAX) * sizeof(xxMatrix4x4) && pointer)
+    {
+        xxMatrix4x4* vpw = reinterpret_cast<xxMatrix4x4*>(*pointer);
+        size -= (2 + INSTANCE_MAX) * sizeof(xxMatrix4x4);
+        (*pointer) += (2 + INSTANCE_MAX) * 4;
+
+        xxCamera* camera = data.camera;
+        if (camera)
+        {
+            vpw[0] = camera->ViewMatrix;
+            vpw[1] = camera->ProjectionMatrix;
+        }
+        else
+        {
+            vpw[0] = xxMatrix4::IDENTITY;
+            vpw[1] = xxMatrix4::IDENTITY;
+        }
+        for (int i = 0; i < instanceCount && i < INSTANCE_MAX; ++i)
+        {
+            vpw[2 + i] = instanceNodes[i]->WorldMatrix;
+        }
+    }
+    if (s)
+    {
+        (*s)(true, "int worldIndex = uniIndex + 8 + int(instanceID) * 4;"                                                                                   );
+        (*s)(true, "float4x4 view = float4x4(uniBuffer[uniIndex + 0], uniBuffer[uniIndex + 1], uniBuffer[uniIndex + 2], uniBuffer[uniIndex + 3]);"         );
+        (*s)(true, "float4x4 projection = float4x4(uniBuffer[uniIndex + 4], uniBuffer[uniIndex + 5], uniBuffer[uniIndex + 6], uniBuffer[uniIndex + 7]);"   );
+        (*s)(true, "float4x4 world = float4x4(uniBuffer[worldIndex + 0], uniBuffer[worldIndex + 1], uniBuffer[worldIndex + 2], uniBuffer[worldIndex + 3]);");
+        (*s)(true, "float4 worldPosition = mul(float4(attrPosition, 1.0), world);"                                                                         );
+        (*s)(true, "float4 screenPosition = mul(mul(worldPosition, view), projection);"                                                                    );
+        (*s)(true, "uniIndex += 8 + SHADER_INSTANCE * 4;"                                                                                                  );
+    }
+}
+//------------------------------------------------------------------------------
+uint64_t Material::GetPipeline(xxMaterial const* material)
+{
+    return static_cast<Material const*>(material)->m_pipeline;
+}
+//------------------------------------------------------------------------------
+bool Material::InstanceAvailable(xxNode const* node)
+{
+    // The instance name only changes with the device
+    static char const* instanceName = nullptr;
+    static bool instanceSupported = false;
+    char const* deviceString = xxGetInstanceName();
+    if (instanceName != deviceString)
+    {
+        instanceName = deviceString;
+        instanceSupported = strstr(deviceString, "Direct3D 1") || strstr(deviceString, "Vulkan") || strstr(deviceString, "Metal 2");
+    }
+    if (instanceSupported == false)
+        return false;
+
+    xxMesh* mesh = node->Mesh.get();
+    if (mesh == nullptr || node->Material == nullptr || node->Bones.empty() == false || mesh->Skinning)
+        return false;
+    if (mesh->Count[xxMesh::STORAGE0] && mesh->Count[xxMesh::STORAGE1] && mesh->Count[xxMesh::STORAGE2])
+        return false;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void Material::SetInstance(xxNode* const* nodes, int count)
+{
+    instanceNodes = nodes;
+    instanceCount = count;
+    instanceDrawn = false;
+    if (count == 0)
+    {
+        Binding::InstanceCount = 0;
+    }
+}
+//------------------------------------------------------------------------------
+int Material::GetInstance()
+{
+    return instanceDrawn ? instanceCount : 0;
+}
+//------------------------------------------------------------------------------
 static xxMaterialPtr (*backupBinaryCreate)();
 //------------------------------------------------------------------------------
 void Material::Initialize()
@@ -42,20 +42,53 @@ protected:
 
     void                UpdateAlphaTestingConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
     void                UpdateBlendingConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
+    void                UpdateClusterLightingConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
     void                UpdateCullingConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
+    void                UpdateInstanceConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
     void                UpdateLightingConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
     void                UpdateSkinningConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
     void                UpdateWorldViewProjectionConstant(xxDrawData const& data, int& size, xxVector4** pointer = nullptr, struct MaterialSelector* s = nullptr) const;
 
+    bool                UpdateInstance(xxDrawData const& data) const;
+    bool                UpdateClusterLighting(xxDrawData const& data) const;
+
     uint64_t            m_meshShader = 0;
     uint16_t            m_meshTextureSlot = 0;
     uint16_t            m_vertexTextureSlot = 0;
     uint16_t            m_fragmentTextureSlot = 0;
 
+    struct Instance
+    {
+        uint64_t        vertexAttribute = 0;
+        uint64_t        vertexShader = 0;
+        uint64_t        pipeline = 0;
+        uint64_t        constants[2] = {};
+        int             constantSize = 0;
+        int             constantIndex = 0;
+    };
+    std::vector<Instance> m_instances;
+    size_t              m_instanceCurrent = 0;
+
+    uint64_t            m_vertexAttribute = 0;
+    int                 m_boneCount = 0;
+
+    uint64_t            m_lightConstants[2] = {};
+    int                 m_lightConstantSize = 0;
+    int                 m_lightConstantIndex = 0;
+    uint32_t            m_lightSerial = 0;
+    bool                m_clusterLighting = false;
+
 public:
     bool                BackfaceCulling = false;
     bool                FrustumCulling = false;
 
+    static constexpr int INSTANCE_MAX = 64;
+
+    static uint64_t     GetPipeline(xxMaterial const* material);
+    static bool         InstanceAvailable(xxNode const* node);
+    static void         SetInstance(xxNode* const* nodes, int count);
+    static int          GetInstance();
+
     static void         Initialize();
     static void         Shutdown();
 
@@ -8,6 +8,7 @@
 #include <array>
 #include <map>
 #include <xxGraphic/internal/xxGraphicInternal.h>
+#include "Resource.h"
 #include "Pipeline.h"
 
 //==============================================================================
@@ -38,14 +39,19 @@ static uint64_t xxCreateBlendStateRuntime(uint64_t device, char const* sourceCol
     hash |= xxBlendFactor(destinationAlpha) << (4 + 4 + 3 + 4);
     hash |= xxBlendOp(operationAlpha)       << (4 + 4 + 3 + 4 + 4);
 
+    Resource::Statistic& statistic = Resource::Current[Resource::PIPELINE];
     auto it = blendStates.find(hash);
     if (it != blendStates.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreateBlendStateSystem(device, sourceColor, operationColor, destinationColor, sourceAlpha, operationAlpha, destinationAlpha);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.created++;
         blendStates.insert(it, {hash, output});
     }
     return output;
@@ -59,10 +65,21 @@ static uint64_t xxCreateDepthStencilStateRuntime(uint64_t device, char const* de
     hash |= xxCompareOp(depthTest)  << 0;
     hash |= depthWrite              << 3;
 
+    Resource::Statistic& statistic = Resource::Current[Resource::PIPELINE];
     uint64_t output = depthStencilStates[hash];
     if (output == 0)
     {
+        statistic.miss++;
         output = depthStencilStates[hash] = xxCreateDepthStencilStateSystem(device, depthTest, depthWrite);
+        if (output != 0)
+        {
+            statistic.count++;
+            statistic.created++;
+        }
+    }
+    else
+    {
+        statistic.hit++;
     }
     return output;
 }
@@ -73,10 +90,21 @@ static uint64_t xxCreateRasterizerStateRuntime(uint64_t device, bool cull, bool
     hash |= cull    << 0;
     hash |= scissor << 1;
 
+    Resource::Statistic& statistic = Resource::Current[Resource::PIPELINE];
     uint64_t output = rasterizerStates[hash];
     if (output == 0)
     {
+        statistic.miss++;
         output = rasterizerStates[hash] = xxCreateRasterizerStateSystem(device, cull, scissor);
+        if (output != 0)
+        {
+            statistic.count++;
+            statistic.created++;
+        }
+    }
+    else
+    {
+        statistic.hit++;
     }
     return output;
 }
@@ -93,14 +121,19 @@ static uint64_t xxCreatePipelineRuntime(uint64_t device, uint64_t renderPass, ui
     hash[6] = vertexShader;
     hash[7] = fragmentShader;
 
+    Resource::Statistic& statistic = Resource::Current[Resource::PIPELINE];
     auto it = pipelines.find(hash);
     if (it != pipelines.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreatePipelineSystem(device, renderPass, blendState, depthStencilState, rasterizerState, vertexAttribute, meshShader, vertexShader, fragmentShader);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.created++;
         pipelines.insert(it, {hash, output});
     }
     return output;
@@ -170,6 +203,7 @@ void Pipeline::Shutdown()
         xxDestroyPipelineSystem(pipeline);
     blendStates.clear();
     pipelines.clear();
+    Resource::Current[Resource::PIPELINE] = {};
     xxCreateBlendState = xxCreateBlendStateSystem;
     xxCreateDepthStencilState = xxCreateDepthStencilStateSystem;
     xxCreateRasterizerState = xxCreateRasterizerStateSystem;
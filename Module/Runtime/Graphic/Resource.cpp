@@ -0,0 +1,50 @@
+//==============================================================================
+// Minamoto : Resource Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include "Resource.h"
+
+//==============================================================================
+static Resource::Statistic frames[Resource::TYPE_COUNT];
+static char const* const names[Resource::TYPE_COUNT] =
+{
+    "Pipeline",
+    "Shader",
+    "Sampler",
+    "VertexAttribute",
+    "Texture",
+    "Buffer",
+};
+//------------------------------------------------------------------------------
+Resource::Statistic Resource::Current[TYPE_COUNT];
+//==============================================================================
+Resource::Statistic const& Resource::Get(Type type)
+{
+    static Statistic const empty = {};
+    if (type < 0 || type >= TYPE_COUNT)
+        return empty;
+    return frames[type];
+}
+//------------------------------------------------------------------------------
+char const* Resource::Name(Type type)
+{
+    if (type < 0 || type >= TYPE_COUNT)
+        return "";
+    return names[type];
+}
+//------------------------------------------------------------------------------
+void Resource::Update()
+{
+    // Creations, hits and misses are reported per frame
+    for (int i = 0; i < TYPE_COUNT; ++i)
+    {
+        frames[i] = Current[i];
+        Current[i].created = 0;
+        Current[i].hit = 0;
+        Current[i].miss = 0;
+    }
+}
+//==============================================================================
@@ -0,0 +1,39 @@
+//==============================================================================
+// Minamoto : Resource Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI Resource
+{
+    enum Type
+    {
+        PIPELINE,
+        SHADER,
+        SAMPLER,
+        VERTEX_ATTRIBUTE,
+        TEXTURE,
+        BUFFER,
+        TYPE_COUNT,
+    };
+
+    struct Statistic
+    {
+        size_t count;
+        size_t bytes;
+        size_t created;
+        size_t hit;
+        size_t miss;
+        size_t pending;
+    };
+
+    static Statistic const& Get(Type type);
+    static char const* Name(Type type);
+    static void Update();
+
+    static Statistic Current[TYPE_COUNT];
+};
@@ -5,6 +5,7 @@
 // https://github.com/metarutaiga/minamoto
 //==============================================================================
 #include "Runtime.h"
+#include "Resource.h"
 #include "Sampler.h"
 
 //==============================================================================
@@ -29,10 +30,21 @@ static uint64_t xxCreateSamplerRuntime(uint64_t device, bool clampU, bool clampV
     hash |= linearMip           << 5;
     hash |= log2(anisotropy)    << 6;
 
+    Resource::Statistic& statistic = Resource::Current[Resource::SAMPLER];
     uint64_t output = samplers[hash];
     if (output == 0)
     {
+        statistic.miss++;
         output = samplers[hash] = xxCreateSamplerSystem(device, clampU, clampV, clampW, linearMag, linearMin, linearMip, anisotropy);
+        if (output != 0)
+        {
+            statistic.count++;
+            statistic.created++;
+        }
+    }
+    else
+    {
+        statistic.hit++;
     }
     return output;
 }
@@ -63,6 +75,7 @@ void Sampler::Shutdown()
         }
         sampler = 0;
     }
+    Resource::Current[Resource::SAMPLER] = {};
     xxCreateSampler = xxCreateSamplerSystem;
     xxDestroySampler = xxDestroySamplerSystem;
     xxCreateSamplerSystem = nullptr;
@@ -7,6 +7,7 @@
 #include "Runtime.h"
 #include <map>
 #include <string_view>
+#include "Resource.h"
 #include "Shader.h"
 
 //==============================================================================
@@ -22,15 +23,21 @@ static void     (*xxDestroyShaderSystem)(uint64_t device, uint64_t shader);
 //------------------------------------------------------------------------------
 static uint64_t xxCreateMeshShaderRuntime(uint64_t device, char const* shader)
 {
+    Resource::Statistic& statistic = Resource::Current[Resource::SHADER];
     size_t hash = std::hash<std::string_view>()(shader);
     auto it = meshShaders.find(hash);
     if (it != meshShaders.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreateMeshShaderSystem(device, shader);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.bytes += strlen(shader);
+        statistic.created++;
         defaultDevice = device;
         meshShaders.insert(it, {hash, output});
     }
@@ -39,15 +46,21 @@ static uint64_t xxCreateMeshShaderRuntime(uint64_t device, char const* shader)
 //------------------------------------------------------------------------------
 static uint64_t xxCreateVertexShaderRuntime(uint64_t device, char const* shader, uint64_t vertexAttribute)
 {
+    Resource::Statistic& statistic = Resource::Current[Resource::SHADER];
     size_t hash = std::hash<std::string_view>()(shader);
     auto it = vertexShaders.find(hash);
     if (it != vertexShaders.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreateVertexShaderSystem(device, shader, vertexAttribute);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.bytes += strlen(shader);
+        statistic.created++;
         defaultDevice = device;
         vertexShaders.insert(it, {hash, output});
     }
@@ -56,15 +69,21 @@ static uint64_t xxCreateVertexShaderRuntime(uint64_t device, char const* shader,
 //------------------------------------------------------------------------------
 static uint64_t xxCreateFragmentShaderRuntime(uint64_t device, char const* shader)
 {
+    Resource::Statistic& statistic = Resource::Current[Resource::SHADER];
     size_t hash = std::hash<std::string_view>()(shader);
     auto it = fragmentShaders.find(hash);
     if (it != fragmentShaders.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreateFragmentShaderSystem(device, shader);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.bytes += strlen(shader);
+        statistic.created++;
         defaultDevice = device;
         fragmentShaders.insert(it, {hash, output});
     }
@@ -103,6 +122,7 @@ void Shader::Shutdown()
     meshShaders.clear();
     vertexShaders.clear();
     fragmentShaders.clear();
+    Resource::Current[Resource::SHADER] = {};
     xxCreateMeshShader = xxCreateMeshShaderSystem;
     xxCreateVertexShader = xxCreateVertexShaderSystem;
     xxCreateFragmentShader = xxCreateFragmentShaderSystem;
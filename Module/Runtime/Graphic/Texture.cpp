@@ -9,6 +9,7 @@
 #include <map>
 #include <xxGraphicPlus/xxFile.h>
 #include <xxGraphicPlus/xxTexture.h>
+#include "Resource.h"
 #include "Texture.h"
 
 #include <Tools/WindowsHeader.h>
@@ -33,17 +34,113 @@
 
 //==============================================================================
 static std::map<std::string, xxTexturePtr> textures;
+static std::map<uint64_t, size_t> textureSizes;
+struct DirtyRect { std::weak_ptr<xxTexture> texture; int left; int top; int right; int bottom; };
+static std::map<xxTexture*, DirtyRect> dirtyRects;
 //------------------------------------------------------------------------------
+static int& PartialState()
+{
+    // -1 : Unknown, 0 : Mapped memory is undefined, 1 : Mapped memory keeps the previous contents
+    static char const* instanceName = nullptr;
+    static int partialState = -1;
+    char const* deviceString = xxGetInstanceName();
+    if (instanceName != deviceString)
+    {
+        instanceName = deviceString;
+        partialState = -1;
+    }
+    return partialState;
+}
+//------------------------------------------------------------------------------
+static bool PartialAvailable()
+{
+    return PartialState() != 0;
+}
+//------------------------------------------------------------------------------
+static int PartialProbe(xxTexturePtr const& texture, char const* map, int stride)
+{
+    // The first mapping on a device is compared with the uploaded contents,
+    // a texture without any content cannot tell retained memory from cleared memory
+    size_t size = Texture::Calculate(texture->Format, texture->Width, 1, 1);
+    bool empty = true;
+    bool retained = true;
+    for (int y = 0; y < texture->Height; ++y)
+    {
+        char const* line = (char*)(*texture)(0, y);
+        if (empty && std::any_of(line, line + size, [](char c) { return c != 0; }))
+            empty = false;
+        if (retained && memcmp(map + stride * y, line, size) != 0)
+            retained = false;
+    }
+    if (empty)
+        return -1;
+    return retained ? 1 : 0;
+}
+//------------------------------------------------------------------------------
+static uint64_t (*xxCreateTextureSystem)(uint64_t device, uint64_t format, int width, int height, int depth, int mipmap, int array, void const* external);
+static void     (*xxDestroyTextureSystem)(uint64_t texture);
+//------------------------------------------------------------------------------
+static uint64_t xxCreateTextureRuntime(uint64_t device, uint64_t format, int width, int height, int depth, int mipmap, int array, void const* external)
+{
+    uint64_t output = xxCreateTextureSystem(device, format, width, height, depth, mipmap, array, external);
+    if (output != 0)
+    {
+        size_t size = 0;
+        for (int m = 0; m < mipmap; ++m)
+        {
+            size += Texture::Calculate(format, std::max(width >> m, 1), std::max(height >> m, 1), std::max(depth >> m, 1));
+        }
+        size *= std::max(array, 1);
+
+        Resource::Statistic& statistic = Resource::Current[Resource::TEXTURE];
+        statistic.count++;
+        statistic.bytes += size;
+        statistic.created++;
+        textureSizes[output] = size;
+    }
+    return output;
+}
+//------------------------------------------------------------------------------
+static void xxDestroyTextureRuntime(uint64_t texture)
+{
+    auto it = textureSizes.find(texture);
+    if (it != textureSizes.end())
+    {
+        Resource::Statistic& statistic = Resource::Current[Resource::TEXTURE];
+        statistic.count--;
+        statistic.bytes -= (*it).second;
+        textureSizes.erase(it);
+    }
+    xxDestroyTextureSystem(texture);
+}
+//==============================================================================
 void Texture::Initialize()
 {
     xxTexture::Calculate = Texture::Calculate;
     xxTexture::Loader = Texture::Loader;
     xxTexture::Reader = Texture::Reader;
+
+    if (xxCreateTextureSystem)
+        return;
+    xxCreateTextureSystem = xxCreateTexture;
+    xxDestroyTextureSystem = xxDestroyTexture;
+    xxCreateTexture = xxCreateTextureRuntime;
+    xxDestroyTexture = xxDestroyTextureRuntime;
 }
 //------------------------------------------------------------------------------
 void Texture::Shutdown()
 {
     textures.clear();
+    dirtyRects.clear();
+
+    if (xxCreateTextureSystem == nullptr)
+        return;
+    textureSizes.clear();
+    Resource::Current[Resource::TEXTURE] = {};
+    xxCreateTexture = xxCreateTextureSystem;
+    xxDestroyTexture = xxDestroyTextureSystem;
+    xxCreateTextureSystem = nullptr;
+    xxDestroyTextureSystem = nullptr;
 }
 //------------------------------------------------------------------------------
 size_t Texture::Calculate(uint64_t format, int width, int height, int depth)
@@ -92,12 +189,15 @@ void Texture::Loader(xxTexturePtr& texture, std::string const& path)
     if (texture == nullptr || (*texture)() != nullptr)
         return;
 
+    Resource::Statistic& statistic = Resource::Current[Resource::TEXTURE];
     auto& ref = textures[texture->Name];
     if (ref != nullptr)
     {
+        statistic.hit++;
         texture = ref;
         return;
     }
+    statistic.miss++;
     ref = texture;
 
     texture->Path = path;
@@ -375,4 +475,67 @@ void Texture::STBReader(xxTexturePtr const& texture, std::string const& filename
 
     stbi_image_free(uc);
 }
+//------------------------------------------------------------------------------
+void Texture::Dirty(xxTexturePtr const& texture, int x, int y, int width, int height)
+{
+    if (texture == nullptr || width <= 0 || height <= 0)
+        return;
+
+    // Textures which are not created yet are uploaded entirely
+    if (texture->Texture == 0 || texture->Dirty || PartialAvailable() == false)
+    {
+        texture->Dirty = true;
+        return;
+    }
+
+    auto& rect = dirtyRects[texture.get()];
+    if (rect.texture.lock() != texture)
+    {
+        rect = { texture, x, y, x + width, y + height };
+        return;
+    }
+    rect.left = std::min(rect.left, x);
+    rect.top = std::min(rect.top, y);
+    rect.right = std::max(rect.right, x + width);
+    rect.bottom = std::max(rect.bottom, y + height);
+}
+//------------------------------------------------------------------------------
+void Texture::Update(xxTexturePtr const& texture, uint64_t device)
+{
+    if (dirtyRects.empty() == false)
+    {
+        auto it = dirtyRects.find(texture.get());
+        if (it != dirtyRects.end())
+        {
+            DirtyRect rect = (*it).second;
+            dirtyRects.erase(it);
+
+            // Only the rows and columns touched since the last upload are copied into the mapped texture
+            int stride = 0;
+            char* map = nullptr;
+            if (rect.texture.lock() == texture && texture->Texture && texture->Dirty == false)
+                map = (char*)xxMapTexture(device, texture->Texture, &stride, 0, 0);
+            if (map)
+            {
+                int& state = PartialState();
+                if (state == -1)
+                    state = PartialProbe(texture, map, stride);
+                if (state != 1)
+                    rect = { rect.texture, 0, 0, texture->Width, texture->Height };
+                size_t offset = Calculate(texture->Format, rect.left, 1, 1);
+                size_t size = Calculate(texture->Format, rect.right - rect.left, 1, 1);
+                for (int y = rect.top; y < rect.bottom; ++y)
+                {
+                    memcpy(map + stride * y + offset, (*texture)(rect.left, y), size);
+                }
+                xxUnmapTexture(device, texture->Texture, 0, 0);
+            }
+            else
+            {
+                texture->Dirty = true;
+            }
+        }
+    }
+    texture->Update(device);
+}
 //==============================================================================
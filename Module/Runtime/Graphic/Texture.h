@@ -18,4 +18,6 @@ struct RuntimeAPI Texture
     static void DDSReader(xxTexturePtr const& texture, std::string const& filename);
     static void DDSWriter(xxTexturePtr const& texture, std::string const& filename);
     static void STBReader(xxTexturePtr const& texture, std::string const& filename);
+    static void Dirty(xxTexturePtr const& texture, int x, int y, int width, int height);
+    static void Update(xxTexturePtr const& texture, uint64_t device);
 };
@@ -7,6 +7,7 @@
 #include "Runtime.h"
 #include <map>
 #include <vector>
+#include "Resource.h"
 #include "VertexAttribute.h"
 
 //==============================================================================
@@ -17,15 +18,21 @@ static void     (*xxDestroyVertexAttributeSystem)(uint64_t vertexAttribute);
 //------------------------------------------------------------------------------
 static uint64_t xxCreateVertexAttributeRuntime(uint64_t device, int count, int* attribute)
 {
+    Resource::Statistic& statistic = Resource::Current[Resource::VERTEX_ATTRIBUTE];
     std::vector<int> vector(attribute, attribute + count * 4);
     auto it = vertexAttributes.find(vector);
     if (it != vertexAttributes.end())
     {
+        statistic.hit++;
         return (*it).second;
     }
+    statistic.miss++;
     uint64_t output = xxCreateVertexAttributeSystem(device, count, attribute);
     if (output != 0)
     {
+        statistic.count++;
+        statistic.bytes += vector.size() * sizeof(int);
+        statistic.created++;
         vertexAttributes.insert(it, {vector, output});
     }
     return output;
@@ -52,6 +59,7 @@ void VertexAttribute::Shutdown()
     for (auto const& [vector, vertexAttribute] : vertexAttributes)
         xxDestroyVertexAttributeSystem(vertexAttribute);
     vertexAttributes.clear();
+    Resource::Current[Resource::VERTEX_ATTRIBUTE] = {};
     xxCreateVertexAttribute = xxCreateVertexAttributeSystem;
     xxDestroyVertexAttribute = xxDestroyVertexAttributeSystem;
     xxCreateVertexAttributeSystem = nullptr;
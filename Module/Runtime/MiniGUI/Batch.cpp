@@ -0,0 +1,228 @@
+//==============================================================================
+// Minamoto : Batch Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <unordered_map>
+#include <xxGraphicPlus/xxMaterial.h>
+#include <xxGraphicPlus/xxMesh.h>
+#include <xxGraphicPlus/xxNode.h>
+#include "Font.h"
+#include "Window.h"
+#include "Batch.h"
+
+#if HAVE_MINIGUI
+namespace MiniGUI
+{
+//==============================================================================
+struct BatchItem
+{
+    xxNode* window;
+    xxMesh* mesh;
+};
+struct BatchCache
+{
+    std::weak_ptr<xxNode> root;
+    std::vector<xxNodePtr> nodes;
+    std::vector<BatchItem> previous;
+    uint32_t revision;
+};
+static std::unordered_map<xxNode*, BatchCache> batchCaches;
+static std::vector<BatchItem> batchItems;
+//------------------------------------------------------------------------------
+size_t Batch::WindowCount;
+size_t Batch::QuadCount;
+//------------------------------------------------------------------------------
+static size_t Build(xxMeshPtr& mesh, BatchItem const* begin, BatchItem const* end)
+{
+    size_t quadCount = 0;
+    for (BatchItem const& item : std::span(begin, end))
+    {
+        if (item.mesh->VertexCount > 1)
+            quadCount += (item.mesh->VertexCount - 1) / 4;
+    }
+    if (quadCount == 0)
+    {
+        if (mesh)
+            mesh->SetVertexCount(0);
+        return 0;
+    }
+
+    if (mesh == nullptr)
+        mesh = xxMesh::Create(false, 0, 1, 1);
+    if (mesh == nullptr)
+        return 0;
+
+    // Indices only depend on the quad count
+    int vertexCount = int(quadCount * 4);
+    int indexCount = int(quadCount * 6);
+    bool rebuildIndex = mesh->IndexCount != indexCount;
+    mesh->SetVertexCount(vertexCount);
+    if (rebuildIndex)
+    {
+        mesh->SetIndexCount(indexCount);
+        if (vertexCount < 65536)
+        {
+            auto index = (uint16_t*)mesh->Index;
+            for (int i = 0; i < vertexCount; i += 4)
+            {
+                (*index++) = uint16_t(i + 0);
+                (*index++) = uint16_t(i + 1);
+                (*index++) = uint16_t(i + 2);
+                (*index++) = uint16_t(i + 0);
+                (*index++) = uint16_t(i + 2);
+                (*index++) = uint16_t(i + 3);
+            }
+        }
+        else
+        {
+            auto index = (uint32_t*)mesh->Index;
+            for (int i = 0; i < vertexCount; i += 4)
+            {
+                (*index++) = uint32_t(i + 0);
+                (*index++) = uint32_t(i + 1);
+                (*index++) = uint32_t(i + 2);
+                (*index++) = uint32_t(i + 0);
+                (*index++) = uint32_t(i + 2);
+                (*index++) = uint32_t(i + 3);
+            }
+        }
+    }
+
+    // Text vertices are baked into screen space, the first vertex is the payload of the font
+    auto position = mesh->GetPosition();
+    auto color = mesh->GetColor(0);
+    auto texture = mesh->GetTexture(0);
+    for (BatchItem const& item : std::span(begin, end))
+    {
+        if (item.mesh->VertexCount <= 1)
+            continue;
+        xxMatrix4 const& world = item.window->WorldMatrix;
+        int count = (item.mesh->VertexCount - 1) / 4 * 4;
+        auto inputPosition = item.mesh->GetPosition() + 1;
+        auto inputColor = item.mesh->GetColor(0) + 1;
+        auto inputTexture = item.mesh->GetTexture(0) + 1;
+        for (int i = 0; i < count; ++i)
+        {
+            xxVector3 const& input = (*inputPosition++);
+            xxVector4 output;
+            output.v = world.v[0].v * input.x + world.v[1].v * input.y + world.v[2].v * input.z + world.v[3].v;
+            (*position++) = output.xyz;
+            (*color++) = (*inputColor++);
+            (*texture++) = (*inputTexture++);
+        }
+    }
+    mesh->Invalidate();
+
+    return quadCount;
+}
+//==============================================================================
+void Batch::Shutdown(bool suspend)
+{
+    if (suspend)
+    {
+        for (auto& [key, cache] : batchCaches)
+        {
+            cache.previous.clear();
+            for (xxNodePtr const& node : cache.nodes)
+            {
+                if (node->Mesh)
+                    node->Mesh->Invalidate();
+            }
+        }
+        return;
+    }
+    batchCaches = std::unordered_map<xxNode*, BatchCache>();
+    batchItems = std::vector<BatchItem>();
+}
+//------------------------------------------------------------------------------
+void Batch::Draw(xxDrawData& drawData, std::vector<WindowPtr> const& windows)
+{
+    // Text of every window shares the material and the atlas of the font,
+    // other windows are kept in the list without a mesh to split the batch
+    xxMaterialPtr const& material = Font::Material();
+    size_t windowCount = 0;
+    batchItems.clear();
+    for (WindowPtr const& root : windows)
+    {
+        Window::Traversal(root, [&](WindowPtr const& window)
+        {
+            if (window->Mesh == nullptr)
+                return true;
+            if (material && window->Material == material)
+            {
+                batchItems.push_back({ window.get(), window->Mesh.get() });
+                windowCount++;
+            }
+            else
+            {
+                batchItems.push_back({ window.get(), nullptr });
+            }
+            return true;
+        });
+    }
+    WindowCount = windowCount;
+
+    // Each set of windows keeps its own meshes, so views drawing different windows do not rebuild each other
+    xxNodePtr key = windows.empty() ? nullptr : windows.front();
+    auto it = batchCaches.find(key.get());
+    if (it == batchCaches.end() || (*it).second.root.lock() != key)
+    {
+        for (auto expired = batchCaches.begin(); expired != batchCaches.end(); )
+        {
+            if ((*expired).first && (*expired).second.root.expired())
+                expired = batchCaches.erase(expired);
+            else
+                ++expired;
+        }
+        it = batchCaches.insert_or_assign(key.get(), BatchCache{ key }).first;
+    }
+    BatchCache& cache = (*it).second;
+
+    // Rebuild only when a text or a matrix is updated, or the set of windows is changed
+    bool changed = cache.revision != Window::Revision;
+    changed |= cache.previous.size() != batchItems.size();
+    changed |= changed == false && memcmp(cache.previous.data(), batchItems.data(), batchItems.size() * sizeof(BatchItem)) != 0;
+    if (changed)
+    {
+        cache.revision = Window::Revision;
+        cache.previous = batchItems;
+        QuadCount = 0;
+    }
+
+    // Each run of text between other windows is one draw, so the order of painter is kept
+    size_t segment = 0;
+    auto flush = [&](BatchItem const* begin, BatchItem const* end)
+    {
+        if (begin == end)
+            return;
+        if (cache.nodes.size() <= segment)
+            cache.nodes.push_back(xxNode::Create());
+        xxNodePtr const& node = cache.nodes[segment++];
+        if (node == nullptr)
+            return;
+        if (changed)
+            QuadCount += Build(node->Mesh, begin, end);
+        if (node->Mesh == nullptr || node->Mesh->VertexCount == 0)
+            return;
+        node->Material = material;
+        node->Draw(drawData);
+    };
+    BatchItem const* begin = batchItems.data();
+    BatchItem const* end = batchItems.data() + batchItems.size();
+    BatchItem const* run = begin;
+    for (BatchItem const* item = begin; item != end; ++item)
+    {
+        if (item->mesh)
+            continue;
+        flush(run, item);
+        item->window->Draw(drawData);
+        run = item + 1;
+    }
+    flush(run, end);
+}
+//==============================================================================
+}   // namespace MiniGUI
+#endif
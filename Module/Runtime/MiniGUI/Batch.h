@@ -0,0 +1,24 @@
+//==============================================================================
+// Minamoto : Batch Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#if HAVE_MINIGUI
+
+#include "Runtime.h"
+
+namespace MiniGUI
+{
+struct RuntimeAPI Batch
+{
+    static void     Shutdown(bool suspend = false);
+    static void     Draw(xxDrawData& drawData, std::vector<WindowPtr> const& windows);
+
+    static size_t   WindowCount;
+    static size_t   QuadCount;
+};
+}   // namespace MiniGUI
+#endif
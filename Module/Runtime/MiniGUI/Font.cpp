@@ -5,11 +5,20 @@
 // https://github.com/metarutaiga/minamoto
 //==============================================================================
 #include "Runtime.h"
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <freetype/freetype.h>
+#include <xxGraphicPlus/xxFile.h>
 #include <xxGraphicPlus/xxMaterial.h>
 #include <xxGraphicPlus/xxMesh.h>
 #include <xxGraphicPlus/xxTexture.h>
+#include "Graphic/Texture.h"
 #include "Font.h"
 
 #if HAVE_MINIGUI
@@ -20,21 +29,173 @@ namespace MiniGUI
 #define F26DOT6_TO_INT(x)   ((FT_Long)(x) / 64)
 #define SIZE                28
 #define SPACE               1024
+#define ATLAS_MAX           4
 #define GAP                 1
 #define FAIL                -1
+#define NONE                0xFFFF
+#define GLYPH_EMPTY         0
+#define GLYPH_READY         1
+#define GLYPH_ERROR         2
+#define GLYPH_QUEUED        3
+#define PAGE_BITS           8
+#define PAGE_SIZE           (1 << PAGE_BITS)
+#define PAGE_COUNT          ((0x10FFFF >> PAGE_BITS) + 1)
+#define LAYOUT_MAX          256
 //------------------------------------------------------------------------------
+struct Shelf
+{
+    unsigned int y;
+    unsigned int height;
+    unsigned int x;
+    uint32_t used;
+    std::vector<char32_t> glyphs;
+};
+struct Bitmap
+{
+    char32_t codepoint;
+    bool success;
+    bool gray;
+    int left;
+    int top;
+    unsigned int width;
+    unsigned int rows;
+    int pitch;
+    FT_Pos advance;
+    uint8_t const* buffer;
+    std::vector<uint8_t> pixels;
+};
+struct Layout
+{
+    struct Quad
+    {
+        xxVector2 rectLT;
+        xxVector2 rectRB;
+        xxVector2 uvLT;
+        xxVector2 uvRB;
+    };
+    std::string text;
+    std::vector<Quad> quads;
+    float advance;
+    uint32_t generation;
+};
 static FT_Library library;
 static FT_Face face;
 static xxMaterialPtr material;
 static xxTexturePtr texture;
-static unsigned int textureMaxHeight;
-static unsigned int textureStepX;
-static unsigned int textureStepY;
-static std::vector<Font::CharGlyph> codepoints;
-//==============================================================================
-void Font::Initialize()
+static uint64_t textureFormat;
+static unsigned int textureBytes;
+static unsigned int textureHeight;
+static std::vector<Shelf> shelves;
+static std::unique_ptr<Font::CharGlyph[]> codepoints[PAGE_COUNT];
+static uint32_t glyphUsed;
+static uint32_t generation;
+//------------------------------------------------------------------------------
+static std::thread warmThread;
+static std::mutex warmMutex;
+static std::condition_variable warmCondition;
+static std::deque<char32_t> warmRequests;
+static std::deque<Bitmap> warmResults;
+static bool warmRunning;
+//------------------------------------------------------------------------------
+static std::list<Layout> layouts;
+static std::unordered_map<std::string_view, std::list<Layout>::iterator> layoutMap;
+//------------------------------------------------------------------------------
+static Font::CharGlyph& Entry(char32_t codepoint)
 {
-    FT_Init_FreeType(&library);
+    auto& page = codepoints[codepoint >> PAGE_BITS];
+    if (page == nullptr)
+        page = std::make_unique<Font::CharGlyph[]>(PAGE_SIZE);
+    return page[codepoint & (PAGE_SIZE - 1)];
+}
+//------------------------------------------------------------------------------
+static void UpdateCoordinate(Font::CharGlyph& glyph)
+{
+    int width = glyph.rectRB.x - glyph.rectLT.x;
+    int height = glyph.rectRB.y - glyph.rectLT.y;
+    glyph.uvLT.x = float(glyph.atlas.x) / SPACE;
+    glyph.uvLT.y = float(glyph.atlas.y) / textureHeight;
+    glyph.uvRB.x = float(glyph.atlas.x + width) / SPACE;
+    glyph.uvRB.y = float(glyph.atlas.y + height) / textureHeight;
+}
+//------------------------------------------------------------------------------
+static bool AddPage()
+{
+    if (textureHeight >= SPACE * ATLAS_MAX)
+        return false;
+
+    // Glyphs keep their texels, only the vertical coordinates are rescaled
+    xxTexturePtr previous = texture;
+    texture = xxTexture::Create2D(textureFormat, SPACE, textureHeight + SPACE, 1);
+    if (texture == nullptr)
+    {
+        texture = previous;
+        return false;
+    }
+    size_t previousSize = SPACE * textureHeight * textureBytes;
+    memcpy((*texture)(), (*previous)(), previousSize);
+    memset((char*)(*texture)() + previousSize, 0, SPACE * SPACE * textureBytes);
+    textureHeight += SPACE;
+    material->SetTexture(0, texture);
+    for (Shelf const& shelf : shelves)
+    {
+        for (char32_t codepoint : shelf.glyphs)
+            UpdateCoordinate(Entry(codepoint));
+    }
+    generation++;
+    return true;
+}
+//------------------------------------------------------------------------------
+static int Allocate(unsigned int width, unsigned int height)
+{
+    if (width + GAP > SPACE || height + GAP > SPACE)
+        return FAIL;
+
+    // Tightest open shelf
+    int found = FAIL;
+    for (int i = 0; i < int(shelves.size()); ++i)
+    {
+        Shelf const& shelf = shelves[i];
+        if (shelf.height < height || shelf.height > height + height / 4 + 4 || shelf.x + width + GAP > SPACE)
+            continue;
+        if (found == FAIL || shelf.height < shelves[found].height)
+            found = i;
+    }
+    if (found != FAIL)
+        return found;
+
+    // New shelf, growing the atlas by a page when it is full
+    unsigned int top = shelves.empty() ? 0 : shelves.back().y + shelves.back().height + GAP;
+    if (top + height + GAP > textureHeight)
+        AddPage();
+    if (top + height + GAP <= textureHeight && shelves.size() < NONE)
+    {
+        shelves.push_back({ top, height, 0, 0 });
+        return int(shelves.size() - 1);
+    }
+
+    // Least recently used shelf which is tall enough
+    for (int i = 0; i < int(shelves.size()); ++i)
+    {
+        Shelf const& shelf = shelves[i];
+        if (shelf.height < height)
+            continue;
+        if (found == FAIL || shelf.used < shelves[found].used)
+            found = i;
+    }
+    if (found == FAIL)
+        return FAIL;
+    Shelf& shelf = shelves[found];
+    for (char32_t codepoint : shelf.glyphs)
+        Entry(codepoint) = Font::CharGlyph();
+    shelf.glyphs.clear();
+    shelf.x = 0;
+    generation++;
+    return found;
+}
+//------------------------------------------------------------------------------
+static FT_Face OpenFace(FT_Library library)
+{
+    FT_Face face = nullptr;
     FT_New_Face(library, "/System/Library/Fonts/STHeiti Medium.ttc", 0, &face);
     if (face)
     {
@@ -46,110 +207,408 @@ void Font::Initialize()
         };
         FT_Request_Size(face, &request);
     }
-    texture = xxTexture::Create2D("RGBA8888"_CC, SPACE, SPACE, 1);
-    memset((*texture)(), 0, texture->Width * texture->Height * sizeof(uint32_t));
+    return face;
+}
+//------------------------------------------------------------------------------
+static bool Render(FT_Face face, Bitmap& bitmap)
+{
+    bitmap.success = false;
+    if (FT_Load_Char(face, bitmap.codepoint, FT_LOAD_DEFAULT) != FT_Err_Ok ||
+        FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF) != FT_Err_Ok)
+        return false;
+    FT_GlyphSlot const& slot = face->glyph;
+    bitmap.success = true;
+    bitmap.gray = slot->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY;
+    bitmap.left = slot->bitmap_left;
+    bitmap.top = slot->bitmap_top;
+    bitmap.width = slot->bitmap.width;
+    bitmap.rows = slot->bitmap.rows;
+    bitmap.pitch = slot->bitmap.pitch;
+    bitmap.advance = slot->advance.x;
+    bitmap.buffer = slot->bitmap.buffer;
+    return true;
+}
+//------------------------------------------------------------------------------
+static void Insert(Font::CharGlyph& glyph, Bitmap const& bitmap)
+{
+    int index = NONE;
+    if (bitmap.width && bitmap.rows)
+    {
+        index = Allocate(bitmap.width, bitmap.rows);
+        if (index == FAIL)
+        {
+            glyph.state = GLYPH_ERROR;
+            return;
+        }
+    }
+    glyph.rectLT.x = bitmap.left;
+    glyph.rectLT.y = -bitmap.top;
+    glyph.rectRB.x = bitmap.left + bitmap.width;
+    glyph.rectRB.y = -bitmap.top + bitmap.rows;
+    glyph.advance = F26DOT6_TO_INT(bitmap.advance + INT_TO_F26DOT6(GAP + GAP));
+    glyph.shelf = uint16_t(index);
+    glyph.state = GLYPH_READY;
+    if (index == NONE)
+        return;
+    Shelf& shelf = shelves[index];
+    glyph.atlas.x = shelf.x;
+    glyph.atlas.y = shelf.y;
+    UpdateCoordinate(glyph);
+    shelf.x += bitmap.width + GAP;
+    shelf.used = glyph.used;
+    shelf.glyphs.push_back(bitmap.codepoint);
+    if (bitmap.gray == false)
+        return;
+
+    uint8_t const* input = bitmap.buffer;
+    if (textureBytes == sizeof(uint8_t))
+    {
+        uint8_t* output = (uint8_t*)(*texture)(glyph.atlas.x, glyph.atlas.y);
+        for (unsigned int y = 0; y < bitmap.rows; ++y)
+        {
+            memcpy(output, input, bitmap.width);
+            input += bitmap.pitch;
+            output += SPACE;
+        }
+    }
+    else
+    {
+        uint32_t* output = (uint32_t*)(*texture)(glyph.atlas.x, glyph.atlas.y);
+        for (unsigned int y = 0; y < bitmap.rows; ++y)
+        {
+            uint8_t const* gray = input;
+            uint32_t* pixel = output;
+            for (unsigned int x = 0; x < bitmap.width; ++x)
+            {
+                (*pixel++) = ((*gray++) << 24) | 0x00FFFFFF;
+            }
+            input += bitmap.pitch;
+            output += SPACE;
+        }
+    }
+    Texture::Dirty(texture, glyph.atlas.x, glyph.atlas.y, bitmap.width, bitmap.rows);
+}
+//------------------------------------------------------------------------------
+static void WarmWorker()
+{
+    // FreeType faces are not thread safe, the worker owns its own library and face
+    FT_Library library = nullptr;
+    FT_Init_FreeType(&library);
+    FT_Face face = OpenFace(library);
+    for (;;)
+    {
+        Bitmap bitmap = {};
+        {
+            std::unique_lock<std::mutex> lock(warmMutex);
+            warmCondition.wait(lock, []{ return warmRunning == false || warmRequests.empty() == false; });
+            if (warmRunning == false)
+                break;
+            bitmap.codepoint = warmRequests.front();
+            warmRequests.pop_front();
+        }
+        if (face && Render(face, bitmap) && bitmap.gray)
+        {
+            bitmap.pixels.resize(bitmap.width * bitmap.rows);
+            for (unsigned int y = 0; y < bitmap.rows; ++y)
+            {
+                memcpy(bitmap.pixels.data() + y * bitmap.width, bitmap.buffer + y * bitmap.pitch, bitmap.width);
+            }
+            bitmap.pitch = bitmap.width;
+        }
+        bitmap.buffer = nullptr;
+        std::lock_guard<std::mutex> lock(warmMutex);
+        warmResults.push_back(std::move(bitmap));
+    }
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+}
+//------------------------------------------------------------------------------
+static void CreateAtlas()
+{
+    // Shader model 2 and OpenGL ES 2.0 have no single channel format, the distance is widened into alpha
+    char const* deviceString = xxGetInstanceName();
+    if (strstr(deviceString, "Metal") || strstr(deviceString, "Direct3D 1") || strstr(deviceString, "Vulkan"))
+    {
+        textureFormat = "R8"_CC;
+        textureBytes = sizeof(uint8_t);
+    }
+    else
+    {
+        textureFormat = "RGBA8888"_CC;
+        textureBytes = sizeof(uint32_t);
+    }
+    texture = xxTexture::Create2D(textureFormat, SPACE, SPACE, 1);
+    memset((*texture)(), 0, texture->Width * texture->Height * textureBytes);
+    textureHeight = SPACE;
+    shelves = std::vector<Shelf>();
+    for (auto& page : codepoints)
+        page = nullptr;
+    material->SetTexture(0, texture);
+    generation++;
+}
+//------------------------------------------------------------------------------
+static float Kerning(FT_UInt left, FT_UInt right)
+{
+    if (face == nullptr || left == 0 || right == 0 || FT_HAS_KERNING(face) == 0)
+        return 0.0f;
+    FT_Vector delta = {};
+    if (FT_Get_Kerning(face, left, right, FT_KERNING_UNFITTED, &delta) != FT_Err_Ok)
+        return 0.0f;
+    return delta.x / 64.0f;
+}
+//------------------------------------------------------------------------------
+static Layout const& GetLayout(std::string_view text)
+{
+    if (textureFormat == 0)
+        CreateAtlas();
+
+    auto it = layoutMap.find(text);
+    if (it != layoutMap.end())
+    {
+        layouts.splice(layouts.begin(), layouts, it->second);
+        if (layouts.front().generation == generation)
+            return layouts.front();
+    }
+    else
+    {
+        if (layouts.size() >= LAYOUT_MAX)
+        {
+            layoutMap.erase(layouts.back().text);
+            layouts.pop_back();
+        }
+        layouts.emplace_front();
+        layouts.front().text = text;
+        layoutMap.emplace(layouts.front().text, layouts.begin());
+    }
+
+    // Quads are kept in pixels of the font size, an eviction in the middle restarts once
+    Layout& layout = layouts.front();
+    for (int retry = 0; retry < 2; ++retry)
+    {
+        uint32_t begin = generation;
+        float advanced = 0.0f;
+        float height = SIZE;
+        FT_UInt previous = 0;
+        layout.quads.clear();
+        layout.advance = 0.0f;
+        std::string_view view = layout.text;
+        while (char32_t w = Font::ToCodePoint(view))
+        {
+            if (w == '\n')
+            {
+                advanced = 0.0f;
+                height += SIZE;
+                previous = 0;
+                continue;
+            }
+            if (w < 0x20)
+                continue;
+            Font::CharGlyph const* glyph = Font::Glyph(w);
+            if (glyph == nullptr)
+            {
+                previous = 0;
+                continue;
+            }
+
+            // Kerning pairs are resolved once per layout
+            FT_UInt index = FT_Get_Char_Index(face, w);
+            float kerning = Kerning(previous, index);
+            advanced += kerning;
+            layout.advance += kerning;
+            previous = index;
+
+            Layout::Quad& quad = layout.quads.emplace_back();
+            quad.rectLT = { advanced + glyph->rectLT.x, height + glyph->rectLT.y };
+            quad.rectRB = { advanced + glyph->rectRB.x, height + glyph->rectRB.y };
+            quad.uvLT = glyph->uvLT;
+            quad.uvRB = glyph->uvRB;
+            advanced += glyph->advance;
+            layout.advance += glyph->advance;
+        }
+        if (begin == generation)
+            break;
+    }
+    layout.generation = generation;
+
+    return layout;
+}
+//==============================================================================
+void Font::Initialize()
+{
+    FT_Init_FreeType(&library);
+    face = OpenFace(library);
     material = xxMaterial::Create();
     material->AmbientColor = xxVector3::ONE;
     material->AlphaTest = true;
     material->AlphaTestReference = 0.25f;
-    material->SetTexture(0, texture);
+    CreateAtlas();
 }
 //------------------------------------------------------------------------------
 void Font::Shutdown(bool suspend)
 {
     if (suspend)
     {
+        // The next device may not support the atlas format, text is rebuilt on resume
         texture->Invalidate();
+        textureFormat = 0;
+        generation++;
         return;
     }
 
+    if (warmThread.joinable())
+    {
+        warmMutex.lock();
+        warmRunning = false;
+        warmMutex.unlock();
+        warmCondition.notify_all();
+        warmThread.join();
+    }
+    warmRequests.clear();
+    warmResults.clear();
+    layoutMap.clear();
+    layouts.clear();
+
     FT_Done_Face(face);
     FT_Done_FreeType(library);
+    face = nullptr;
+    library = nullptr;
     material = nullptr;
     texture = nullptr;
-    codepoints = std::vector<CharGlyph>();
+    textureFormat = 0;
+    textureHeight = 0;
+    shelves = std::vector<Shelf>();
+    for (auto& page : codepoints)
+        page = nullptr;
+    generation++;
 }
 //------------------------------------------------------------------------------
 xxVector2 Font::Extent(std::string_view text, float scale)
 {
-    xxVector2 extent = xxVector2::ZERO;
-    while (char32_t w = ToCodePoint(text))
-    {
-        CharGlyph const* glyph = Glyph(w);
-        if (glyph == nullptr)
-            continue;
-        extent.x += glyph->advance * (scale / SIZE);
-    }
+    Layout const& layout = GetLayout(text);
+    xxVector2 extent;
+    extent.x = layout.advance * (scale / SIZE);
     extent.y = SIZE * (scale / SIZE);
     return extent;
 }
 //------------------------------------------------------------------------------
+bool Font::Expired(xxMeshPtr const& mesh)
+{
+    if (mesh == nullptr || mesh->VertexCount == 0 || mesh->TextureCount == 0)
+        return false;
+    return mesh->GetTexture(0)[0].x != float(generation);
+}
+//------------------------------------------------------------------------------
+uint32_t Font::Generation()
+{
+    return generation;
+}
+//------------------------------------------------------------------------------
 Font::CharGlyph const* Font::Glyph(char32_t codepoint)
 {
     if (codepoint > 0x10FFFF)
         return nullptr;
-    if (codepoints.size() <= codepoint)
-        codepoints.resize(codepoint + 1);
-    CharGlyph& glyph = codepoints[codepoint];
+    if (textureFormat == 0)
+        CreateAtlas();
+    CharGlyph& glyph = Entry(codepoint);
+    glyph.used = ++glyphUsed;
     xxLocalBreak()
     {
-        if (glyph.rectLT.x != 0.0f)
-            break;
-        if (FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT) != FT_Err_Ok ||
-            FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF) != FT_Err_Ok)
+        if (glyph.state != GLYPH_EMPTY && glyph.state != GLYPH_QUEUED)
         {
-            glyph.rectLT.x = FAIL;
+            if (glyph.state == GLYPH_READY && glyph.shelf != NONE)
+                shelves[glyph.shelf].used = glyph.used;
             break;
         }
-        FT_GlyphSlot const& slot = face->glyph;
-        FT_Bitmap const& bitmap = slot->bitmap;
-        if (textureStepX + bitmap.width >= SPACE)
-        {
-            textureStepX = 0;
-            textureStepY += textureMaxHeight + GAP;
-            textureMaxHeight = 0;
-        }
-        if (textureStepY + bitmap.rows >= SPACE)
+        Bitmap bitmap = {};
+        bitmap.codepoint = codepoint;
+        if (Render(face, bitmap) == false)
         {
-            glyph.rectLT.x = FAIL;
+            glyph.state = GLYPH_ERROR;
             break;
         }
-        glyph.rectLT.x = slot->bitmap_left;
-        glyph.rectLT.y = -slot->bitmap_top;
-        glyph.rectRB.x = slot->bitmap_left + bitmap.width;
-        glyph.rectRB.y = -slot->bitmap_top + bitmap.rows;
-        glyph.uvLT.x = float(textureStepX) / SPACE;
-        glyph.uvLT.y = float(textureStepY) / SPACE;
-        glyph.uvRB.x = float(textureStepX + bitmap.width) / SPACE;
-        glyph.uvRB.y = float(textureStepY + bitmap.rows) / SPACE;
-        glyph.advance = F26DOT6_TO_INT(slot->advance.x + INT_TO_F26DOT6(GAP + GAP));
-        switch (bitmap.pixel_mode)
+        Insert(glyph, bitmap);
+    }
+    return glyph.state == GLYPH_READY ? &glyph : nullptr;
+}
+//------------------------------------------------------------------------------
+void Font::Warm(std::string_view text)
+{
+    if (textureFormat == 0)
+        CreateAtlas();
+
+    std::vector<char32_t> requests;
+    while (char32_t w = ToCodePoint(text))
+    {
+        if (w < 0x20 || w > 0x10FFFF)
+            continue;
+        CharGlyph& glyph = Entry(w);
+        if (glyph.state != GLYPH_EMPTY)
+            continue;
+        glyph.state = GLYPH_QUEUED;
+        requests.push_back(w);
+    }
+    if (requests.empty())
+        return;
+
+    warmMutex.lock();
+    warmRequests.insert(warmRequests.end(), requests.begin(), requests.end());
+    warmRunning = true;
+    warmMutex.unlock();
+    if (warmThread.joinable() == false)
+        warmThread = std::thread(WarmWorker);
+    warmCondition.notify_one();
+}
+//------------------------------------------------------------------------------
+void Font::WarmFile(std::string const& filename)
+{
+    xxFile* file = xxFile::Load(filename.c_str());
+    if (file == nullptr)
+        return;
+    std::string text(file->Size(), '\0');
+    text.resize(file->Read(text.data(), text.size()));
+    delete file;
+    Warm(text);
+}
+//------------------------------------------------------------------------------
+void Font::Update(float budget)
+{
+    if (textureFormat == 0)
+        return;
+
+    double begin = 0.0;
+    xxGetCurrentTime(&begin);
+    for (;;)
+    {
+        Bitmap bitmap;
         {
-        case FT_PIXEL_MODE_GRAY:
+            std::lock_guard<std::mutex> lock(warmMutex);
+            if (warmResults.empty())
+                break;
+            bitmap = std::move(warmResults.front());
+            warmResults.pop_front();
+        }
+
+        // Glyphs rendered synchronously or dropped by an atlas reset in the meantime are skipped
+        CharGlyph& glyph = Entry(bitmap.codepoint);
+        if (glyph.state == GLYPH_QUEUED)
         {
-            uint8_t* input = (uint8_t*)bitmap.buffer;
-            uint32_t* output = (uint32_t*)(*texture)(textureStepX, textureStepY);
-            for (unsigned int y = 0; y < bitmap.rows; ++y)
+            if (bitmap.success)
             {
-                uint8_t* gray = input;
-                uint32_t* pixel = output;
-                for (unsigned int x = 0; x < bitmap.width; ++x)
-                {
-                    (*pixel++) = ((*gray++) << 24) | 0x00FFFFFF;
-                }
-                input += bitmap.pitch;
-                output += SPACE;
+                bitmap.buffer = bitmap.pixels.data();
+                glyph.used = ++glyphUsed;
+                Insert(glyph, bitmap);
+            }
+            else
+            {
+                glyph.state = GLYPH_ERROR;
             }
-            textureMaxHeight = std::max(textureMaxHeight, bitmap.rows);
-            textureStepX += bitmap.width + GAP;
-            texture->Dirty = true;
-            break;
         }
-        default:
+
+        double now = 0.0;
+        xxGetCurrentTime(&now);
+        if (now - begin >= budget)
             break;
-        }
     }
-    return glyph.rectLT.x != FAIL ? &glyph : nullptr;
 }
 //------------------------------------------------------------------------------
 xxMaterialPtr Font::Material()
@@ -159,18 +618,9 @@ xxMaterialPtr Font::Material()
 //------------------------------------------------------------------------------
 xxMeshPtr Font::Mesh(xxMeshPtr const& mesh, std::string_view text, xxMatrix3x4 const color, xxVector2 const& scale, float shadow)
 {
-    // Calculate text counts
-    int textCount = 0;
-    std::string_view preText = text;
-    while (char32_t w = ToCodePoint(preText))
-    {
-        if (w < 0x20)
-            continue;
-        CharGlyph const* glyph = Glyph(w);
-        if (glyph == nullptr)
-            continue;
-        textCount++;
-    }
+    // Text layout is shared by every scale, color and shadow
+    Layout const& layout = GetLayout(text);
+    int textCount = int(layout.quads.size());
     if (textCount == 0)
         return nullptr;
 
@@ -220,37 +670,24 @@ xxMeshPtr Font::Mesh(xxMeshPtr const& mesh, std::string_view text, xxMatrix3x4 c
 
     // Glyph
     xxVector2 rescale = scale / SIZE;
-    float advanced = 0.0f;
-    float height = scale.y;
-    while (char32_t w = ToCodePoint(text))
+    for (Layout::Quad const& quad : layout.quads)
     {
-        if (w == '\n')
-        {
-            advanced = 0.0f;
-            height += scale.y;
-            continue;
-        }
-        if (w < 0x20)
-            continue;
-        CharGlyph const* glyph = Glyph(w);
-        if (glyph == nullptr)
-            continue;
-        xxVector2 rectLT = xxVector2{ float(glyph->rectLT.x), float(glyph->rectLT.y) } * rescale;
-        xxVector2 rectRB = xxVector2{ float(glyph->rectRB.x), float(glyph->rectRB.y) } * rescale;
-        (*positions++) = { advanced + rectLT.x, height + rectLT.y, 1.0f };
-        (*positions++) = { advanced + rectRB.x, height + rectLT.y, 1.0f };
-        (*positions++) = { advanced + rectRB.x, height + rectRB.y, 1.0f };
-        (*positions++) = { advanced + rectLT.x, height + rectRB.y, 1.0f };
+        xxVector2 rectLT = quad.rectLT * rescale;
+        xxVector2 rectRB = quad.rectRB * rescale;
+        (*positions++) = { rectLT.x, rectLT.y, 1.0f };
+        (*positions++) = { rectRB.x, rectLT.y, 1.0f };
+        (*positions++) = { rectRB.x, rectRB.y, 1.0f };
+        (*positions++) = { rectLT.x, rectRB.y, 1.0f };
         (*colors++) = textColors[0];
         (*colors++) = textColors[2];
         (*colors++) = textColors[3];
         (*colors++) = textColors[1];
-        (*textures++) = { glyph->uvLT.x, glyph->uvLT.y };
-        (*textures++) = { glyph->uvRB.x, glyph->uvLT.y };
-        (*textures++) = { glyph->uvRB.x, glyph->uvRB.y };
-        (*textures++) = { glyph->uvLT.x, glyph->uvRB.y };
-        advanced += glyph->advance * rescale.x;
+        (*textures++) = { quad.uvLT.x, quad.uvLT.y };
+        (*textures++) = { quad.uvRB.x, quad.uvLT.y };
+        (*textures++) = { quad.uvRB.x, quad.uvRB.y };
+        (*textures++) = { quad.uvLT.x, quad.uvRB.y };
     }
+    output->GetTexture(0)[0] = { float(generation), 0.0f };
     if (shadow > 0.0f)
     {
         auto firstPositions = output->GetPosition() + 1;
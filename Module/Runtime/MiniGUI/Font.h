@@ -27,13 +27,22 @@ struct RuntimeAPI Font
         xxVector2   uvLT = {};
         xxVector2   uvRB = {};
         float       advance = 0.0f;
+        int16x2_t   atlas = {};
+        uint16_t    shelf = 0;
+        uint16_t    state = 0;
+        uint32_t    used = 0;
     };
 
 public:
     static void             Initialize();
     static void             Shutdown(bool suspend = false);
     static xxVector2        Extent(std::string_view text, float scale);
+    static bool             Expired(xxMeshPtr const& mesh);
+    static uint32_t         Generation();
     static CharGlyph const* Glyph(char32_t codepoint);
+    static void             Warm(std::string_view text);
+    static void             WarmFile(std::string const& filename);
+    static void             Update(float budget = 0.001f);
     static xxMaterialPtr    Material();
     static xxMeshPtr        Mesh(xxMeshPtr const& mesh, std::string_view text, xxMatrix3x4 const color, xxVector2 const& scale, float shadow);
     static xxMeshPtr        MeshColor(xxMeshPtr const& mesh, xxMatrix3x4 const color);
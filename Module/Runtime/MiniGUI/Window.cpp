@@ -18,6 +18,16 @@ namespace MiniGUI
 {
 xxVector2 Window::ScreenSize;
 xxVector2 Window::ScreenInvSize;
+uint32_t Window::Revision;
+size_t Window::UpdateCount;
+//------------------------------------------------------------------------------
+struct UpdateRoot
+{
+    std::weak_ptr<xxNode> root;
+    xxVector2 screenSize;
+    uint32_t generation;
+};
+static std::vector<UpdateRoot> updateRoots;
 //==============================================================================
 //  Template
 //==============================================================================
@@ -103,6 +113,7 @@ void Window::SetText(std::string_view const& text)
         return;
     SetType<StringModifier>(TEXT, text);
     Flags |= UPDATE_TEXT;
+    MarkDirty();
 }
 //------------------------------------------------------------------------------
 void Window::SetTextColor(xxMatrix3x4 const& color)
@@ -111,6 +122,7 @@ void Window::SetTextColor(xxMatrix3x4 const& color)
         return;
     SetType<ArrayModifier>(TEXT_COLOR, FromColor4(color));
     Flags |= UPDATE_TEXT_COLOR;
+    MarkDirty();
 }
 //------------------------------------------------------------------------------
 void Window::SetTextScale(float scale)
@@ -119,6 +131,7 @@ void Window::SetTextScale(float scale)
         return;
     SetType<FloatModifier>(TEXT_SCALE, scale);
     Flags |= UPDATE_TEXT_SCALE;
+    MarkDirty();
 }
 //------------------------------------------------------------------------------
 void Window::SetTextShadow(float shadow)
@@ -127,6 +140,7 @@ void Window::SetTextShadow(float shadow)
         return;
     SetType<FloatModifier>(TEXT_SHADOW, shadow);
     Flags |= UPDATE_TEXT_SHADOW;
+    MarkDirty();
 }
 //------------------------------------------------------------------------------
 void Window::UpdateText()
@@ -157,6 +171,18 @@ void Window::UpdateText()
     }
 }
 //------------------------------------------------------------------------------
+void Window::MarkDirty()
+{
+    // Ancestors are marked so the update can skip clean subtrees
+    Flags |= UPDATE_DIRTY;
+    WindowPtr parent = GetParent();
+    while (parent && (parent->Flags & UPDATE_DIRTY) == 0)
+    {
+        parent->Flags |= UPDATE_DIRTY;
+        parent = parent->GetParent();
+    }
+}
+//------------------------------------------------------------------------------
 void Window::SetScale(xxVector2 const& scale)
 {
     LocalMatrix[0].x = scale.x;
@@ -165,12 +191,7 @@ void Window::SetScale(xxVector2 const& scale)
 
     // Update flag
     Flags |= UPDATE_NEED;
-    WindowPtr parent = GetParent();
-    while (parent)
-    {
-        parent->Flags |= UPDATE_NEED;
-        parent = parent->GetParent();
-    }
+    MarkDirty();
 }
 //------------------------------------------------------------------------------
 void Window::SetOffset(xxVector2 const& offset)
@@ -179,12 +200,7 @@ void Window::SetOffset(xxVector2 const& offset)
 
     // Update flag
     Flags |= UPDATE_NEED;
-    WindowPtr parent = GetParent();
-    while (parent)
-    {
-        parent->Flags |= UPDATE_NEED;
-        parent = parent->GetParent();
-    }
+    MarkDirty();
 }
 //==============================================================================
 //  Node
@@ -258,34 +274,78 @@ WindowPtr const& Window::Cast(xxNodePtr const& node)
 //==============================================================================
 //  Update
 //==============================================================================
+static void UpdateWindow(WindowPtr const& window, bool matrix, bool resize, bool refresh)
+{
+    Window::UpdateCount++;
+    if (resize)
+    {
+        window->Flags |= Window::UPDATE_TEXT_SCALE;
+    }
+    if (refresh && window->Mesh && window->Material == Font::Material() && Font::Expired(window->Mesh))
+    {
+        window->Flags |= Window::UPDATE_TEXT;
+    }
+    if (window->Flags & Window::UPDATE_TEXT_FLAGS)
+    {
+        window->UpdateText();
+        Window::Revision++;
+    }
+    if (matrix || (window->Flags & xxNode::UPDATE_NEED))
+    {
+        window->Flags &= ~xxNode::UPDATE_NEED;
+        window->UpdateMatrix();
+        Window::Revision++;
+        matrix = true;
+    }
+    window->Flags &= ~Window::UPDATE_DIRTY;
+
+    // Children of a moved window follow it, the others only when they are marked
+    for (WindowPtr const& child : (*window))
+    {
+        if (matrix || resize || refresh || (child->Flags & (Window::UPDATE_DIRTY | Window::UPDATE_TEXT_FLAGS | xxNode::UPDATE_NEED)))
+        {
+            UpdateWindow(child, matrix, resize, refresh);
+        }
+    }
+}
+//------------------------------------------------------------------------------
 void Window::Update(WindowPtr const& window, float time, xxVector2 const& screenSize)
 {
-    bool resize = false;
     if (ScreenSize != screenSize)
     {
         ScreenSize = screenSize;
         ScreenInvSize = { 1.0f / screenSize.x, 1.0f / screenSize.y };
-        resize = true;
     }
 
-    auto callback = [&](WindowPtr const& window)
+    UpdateRoot* root = nullptr;
+    for (size_t i = 0; i < updateRoots.size(); ++i)
     {
-        if (resize)
+        if (updateRoots[i].root.expired())
         {
-            window->Flags |= UPDATE_TEXT_SCALE;
+            updateRoots.erase(updateRoots.begin() + i);
+            i--;
+            continue;
         }
-        if (window->Flags & UPDATE_TEXT_FLAGS)
-        {
-            window->UpdateText();
-        }
-        if (window->Flags & UPDATE_NEED)
-        {
-            window->Flags &= ~UPDATE_NEED;
-            window->UpdateMatrix();
-        }
-        return true;
-    };
-    Traversal(window, callback);
+        if (updateRoots[i].root.lock() == window)
+            root = &updateRoots[i];
+    }
+    bool resize = true;
+    bool refresh = true;
+    if (root)
+    {
+        resize = root->screenSize != screenSize;
+        refresh = root->generation != Font::Generation();
+    }
+    else
+    {
+        root = &updateRoots.emplace_back();
+        root->root = window;
+    }
+    root->screenSize = screenSize;
+    root->generation = Font::Generation();
+
+    // A resized screen or a rebuilt font atlas refreshes every window of the root
+    UpdateWindow(window, false, resize, refresh);
 }
 //==============================================================================
 //  Binary
@@ -42,6 +42,7 @@ public:
         UPDATE_TEXT_SCALE       = 0x00000080,
         UPDATE_TEXT_SHADOW      = 0x00000100,
         UPDATE_TEXT_FLAGS       = 0x000001E0,
+        UPDATE_DIRTY            = 0x00000200,
     };
 
 public:
@@ -54,6 +55,7 @@ public:
     void                    SetTextScale(float size);
     void                    SetTextShadow(float size);
     void                    UpdateText();
+    void                    MarkDirty();
 
     xxVector2               GetScale() const { return { LocalMatrix[0].x, LocalMatrix[1].y }; }
     xxVector2 const&        GetOffset() const { return LocalMatrix[3].xy; }
@@ -80,6 +82,8 @@ public:
 public:
     static xxVector2        ScreenSize;
     static xxVector2        ScreenInvSize;
+    static uint32_t         Revision;
+    static size_t           UpdateCount;
 };
 }   // namespace MiniGUI
 #endif
@@ -0,0 +1,49 @@
+//==============================================================================
+// Minamoto : LightModifier Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <xxGraphicPlus/xxNode.h>
+#include "Tools/LightTools.h"
+#include "LightModifier.h"
+
+//==============================================================================
+//  LightModifier
+//==============================================================================
+void LightModifier::Update(void* target, xxModifierData* data, float time)
+{
+    // Lights are submitted even when the time is paused, otherwise they expire
+    data->time = time;
+
+    auto node = (xxNode*)target;
+    auto* constant = (Constant*)Data.data();
+
+    // Spot lights point along the negative Z axis of the node
+    LightTools::Light light;
+    light.position = node->WorldMatrix.v[3].xyz;
+    light.range = constant->range;
+    light.color = constant->color * constant->intensity;
+    light.direction = -node->WorldMatrix.v[2].xyz;
+    light.innerAngle = constant->innerAngle;
+    light.outerAngle = constant->outerAngle;
+    LightTools::Add(data, light);
+}
+//------------------------------------------------------------------------------
+xxModifierPtr LightModifier::Create(xxVector3 const& color, float intensity, float range, float innerAngle, float outerAngle)
+{
+    xxModifierPtr modifier = xxModifier::Create(sizeof(Constant));
+    if (modifier == nullptr)
+        return nullptr;
+
+    Loader(*modifier, LIGHT);
+    auto* constant = (Constant*)modifier->Data.data();
+    constant->color = color;
+    constant->intensity = intensity;
+    constant->range = range;
+    constant->innerAngle = innerAngle;
+    constant->outerAngle = outerAngle;
+    return modifier;
+}
+//==============================================================================
@@ -0,0 +1,27 @@
+//==============================================================================
+// Minamoto : LightModifier Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Modifier.h"
+
+class RuntimeAPI LightModifier : public Modifier
+{
+public:
+    struct Constant
+    {
+        xxVector3 color;
+        float intensity;
+        float range;
+        float innerAngle;
+        float outerAngle;
+    };
+
+public:
+    void                    Update(void* target, xxModifierData* data, float time);
+
+    static xxModifierPtr    Create(xxVector3 const& color = xxVector3::WHITE, float intensity = 1.0f, float range = 10.0f, float innerAngle = 0.0f, float outerAngle = 0.0f);
+};
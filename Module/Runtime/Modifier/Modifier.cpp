@@ -19,6 +19,7 @@
 #include "BakedQuaternionModifier.h"
 #include "Quaternion16Modifier.h"
 #include "BakedQuaternion16Modifier.h"
+#include "LightModifier.h"
 #include "Modifier.h"
 
 #define LOADER(class) reinterpret_cast<void(xxModifier::*)(void*, xxModifierData*, float)>(&class::Update)
@@ -46,8 +47,10 @@ static const struct { std::string name; xxModifier::UpdateFunction function; siz
     {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
     { "QUATERNION16",         LOADER(Quaternion16Modifier),       0,                                        sizeof(Quaternion16Modifier::Key) },
     { "BAKED_QUATERNION16",   LOADER(BakedQuaternion16Modifier),  sizeof(BakedQuaternion16Modifier::Baked), sizeof(v4hi) },
+                        {}, {}, {}, {}, {}, {}, {}, {},
+    { "LIGHT",                LOADER(LightModifier),              0,                                        sizeof(LightModifier::Constant) },
 };
-static_assert(xxCountOf(loaders) == Modifier::BAKED_QUATERNION16 + 1);
+static_assert(xxCountOf(loaders) == Modifier::LIGHT + 1);
 //==============================================================================
 void Modifier::Initialize()
 {
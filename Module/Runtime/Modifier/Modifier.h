@@ -32,6 +32,7 @@ public:
         BAKED_SCALE         =  32,
         QUATERNION16        =  50,
         BAKED_QUATERNION16  =  51,
+        LIGHT               =  60,
     };
 
 public:
@@ -12,15 +12,21 @@
 #include "Graphic/Material.h"
 #include "Graphic/Pipeline.h"
 #include "Graphic/RenderPass.h"
+#include "Graphic/Resource.h"
 #include "Graphic/Sampler.h"
 #include "Graphic/Shader.h"
 #include "Graphic/Texture.h"
 #include "Graphic/VertexAttribute.h"
 #if HAVE_MINIGUI
+#include "MiniGUI/Batch.h"
 #include "MiniGUI/Font.h"
 #endif
 #include "Script/Lua.h"
 #include "Script/QuickJS.h"
+#include "Tools/JobSystem.h"
+#include "Tools/LightTools.h"
+#include "Tools/LODTools.h"
+#include "Tools/SkinningTools.h"
 #include "Runtime.h"
 
 //==============================================================================
@@ -43,6 +49,8 @@ void Runtime::Initialize()
     Texture::Initialize();
     VertexAttribute::Initialize();
 
+    JobSystem::Initialize();
+
     Lua::Initialize();
     QuickJS::Initialize();
 
@@ -61,6 +69,14 @@ void Runtime::Initialize()
 void Runtime::Update()
 {
     Buffer::Update();
+    Resource::Update();
+    LightTools::Flush();
+    LODTools::Flush();
+    SkinningTools::Flush();
+
+#if HAVE_MINIGUI
+    MiniGUI::Font::Update();
+#endif
 }
 //------------------------------------------------------------------------------
 void Runtime::Shutdown(bool suspend)
@@ -84,9 +100,11 @@ void Runtime::Shutdown(bool suspend)
     {
         QuickJS::Shutdown();
         Lua::Shutdown();
+        JobSystem::Shutdown();
     }
 
 #if HAVE_MINIGUI
+    MiniGUI::Batch::Shutdown(suspend);
     MiniGUI::Font::Shutdown(suspend);
 #endif
 
@@ -7,6 +7,13 @@
 #include "Runtime.h"
 #include <queue>
 #include <string>
+#include <unordered_map>
+#include <xxGraphicPlus/xxCamera.h>
+#include <xxGraphicPlus/xxNode.h>
+#include "Graphic/Resource.h"
+#include "Modifier/Modifier.h"
+#include "Tools/BVH.h"
+#include "Tools/NodeTools.h"
 #include "Lua.h"
 
 extern "C"
@@ -26,6 +33,16 @@ extern "C"
 
 lua_State* Lua::L;
 char const Lua::Version[] = "Lua " LUA_VERSION_MAJOR "." LUA_VERSION_MINOR "." LUA_VERSION_RELEASE;
+//------------------------------------------------------------------------------
+struct LuaNode
+{
+    std::weak_ptr<xxNode> node;
+    uintptr_t handle;
+};
+static std::unordered_map<xxNode*, LuaNode> luaNodes;
+static std::unordered_map<uintptr_t, std::weak_ptr<xxNode>> luaHandles;
+static uintptr_t luaHandleSerial = 0;
+static size_t luaNodePrune = 256;
 //==============================================================================
 void Lua::Initialize()
 {
@@ -69,6 +86,8 @@ void Lua::Initialize()
         }
         lua_gc(L, LUA_GCRESTART);  /* start GC... */
         lua_gc(L, LUA_GCGEN, 0, 0);  /* ...in generational mode */
+
+        RuntimeLibrary();
     }
 }
 //------------------------------------------------------------------------------
@@ -77,10 +96,443 @@ void Lua::Shutdown()
     lua_close(L);
 
     L = nullptr;
+    luaNodes = std::unordered_map<xxNode*, LuaNode>();
+    luaHandles = std::unordered_map<uintptr_t, std::weak_ptr<xxNode>>();
+    luaNodePrune = 256;
+}
+//------------------------------------------------------------------------------
+static int lua_engine_query(lua_State* L)
+{
+    int magic = int(lua_tointeger(L, lua_upvalueindex(1)));
+    float args[6] = {};
+    for (int i = 0; i < 6; ++i)
+    {
+        args[i] = float(luaL_optnumber(L, i + 1, 0.0));
+    }
+    BVH* bvh = BVH::Current;
+    if (magic == 3)
+    {
+        xxNodePtr node = bvh ? bvh->Pick({ args[0], args[1], args[2] }, { args[3], args[4], args[5] }) : nullptr;
+        if (node)
+            lua_pushstring(L, node->Name.c_str());
+        else
+            lua_pushnil(L);
+        return 1;
+    }
+    lua_newtable(L);
+    if (bvh == nullptr)
+        return 1;
+    lua_Integer index = 0;
+    auto callback = [&](xxNodePtr const& node)
+    {
+        lua_pushstring(L, node->Name.c_str());
+        lua_rawseti(L, -2, ++index);
+    };
+    switch (magic)
+    {
+    case 0:
+        bvh->QuerySphere({ args[0], args[1], args[2], args[3] }, callback);
+        break;
+    case 1:
+        bvh->QueryBox({ args[0], args[1], args[2] }, { args[3], args[4], args[5] }, callback);
+        break;
+    case 2:
+        bvh->QueryRay({ args[0], args[1], args[2] }, { args[3], args[4], args[5] }, [&](xxNodePtr const& node, float) { callback(node); });
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+//------------------------------------------------------------------------------
+static int lua_engine_statistic(lua_State* L)
+{
+    lua_newtable(L);
+    for (int i = 0; i < Resource::TYPE_COUNT; ++i)
+    {
+        Resource::Statistic const& statistic = Resource::Get(Resource::Type(i));
+        lua_newtable(L);
+        lua_pushinteger(L, lua_Integer(statistic.count));
+        lua_setfield(L, -2, "count");
+        lua_pushinteger(L, lua_Integer(statistic.bytes));
+        lua_setfield(L, -2, "bytes");
+        lua_pushinteger(L, lua_Integer(statistic.created));
+        lua_setfield(L, -2, "created");
+        lua_pushinteger(L, lua_Integer(statistic.hit));
+        lua_setfield(L, -2, "hit");
+        lua_pushinteger(L, lua_Integer(statistic.miss));
+        lua_setfield(L, -2, "miss");
+        lua_pushinteger(L, lua_Integer(statistic.pending));
+        lua_setfield(L, -2, "pending");
+        lua_setfield(L, -2, Resource::Name(Resource::Type(i)));
+    }
+    return 1;
+}
+//==============================================================================
+//  Node
+//==============================================================================
+static void lua_pushnode(lua_State* L, xxNodePtr const& node)
+{
+    if (node == nullptr)
+    {
+        lua_pushnil(L);
+        return;
+    }
+
+    // Handles are light userdata holding a serial, so a node allocated at a released address gets a new handle
+    if (luaNodes.size() >= luaNodePrune)
+    {
+        for (auto it = luaNodes.begin(); it != luaNodes.end(); )
+        {
+            if (it->second.node.expired())
+                it = luaNodes.erase(it);
+            else
+                ++it;
+        }
+        for (auto it = luaHandles.begin(); it != luaHandles.end(); )
+        {
+            if (it->second.expired())
+                it = luaHandles.erase(it);
+            else
+                ++it;
+        }
+        luaNodePrune = std::max<size_t>(256, luaNodes.size() * 2);
+    }
+    LuaNode& entry = luaNodes[node.get()];
+    if (entry.node.lock() != node)
+    {
+        entry.node = node;
+        entry.handle = ++luaHandleSerial;
+        luaHandles[entry.handle] = node;
+    }
+    lua_pushlightuserdata(L, (void*)entry.handle);
+}
+//------------------------------------------------------------------------------
+static xxNode* lua_tonode(lua_State* L, int index)
+{
+    auto handle = (uintptr_t)lua_touserdata(L, index);
+    auto it = luaHandles.find(handle);
+    if (it == luaHandles.end() || it->second.expired())
+        return nullptr;
+    return it->second.lock().get();
+}
+//------------------------------------------------------------------------------
+static xxNode* lua_checknode(lua_State* L, int index)
+{
+    xxNode* node = lua_tonode(L, index);
+    if (node == nullptr)
+        luaL_argerror(L, index, "invalid node");
+    return node;
+}
+//------------------------------------------------------------------------------
+static void lua_marknode(xxNode* node)
+{
+    // Static subtrees are skipped by the update until they are marked
+    node->Flags |= xxNode::UPDATE_NEED;
+    xxNode* parent = node;
+    while (parent && (parent->Flags & xxNode::UPDATE_SKIP))
+    {
+        parent->Flags &= ~xxNode::UPDATE_SKIP;
+        parent = parent->GetParent().get();
+    }
+}
+//------------------------------------------------------------------------------
+static bool lua_tofloats(lua_State* L, int index, size_t offset, float* output, int count)
+{
+    // Packed native floats from string.pack are copied without touching the stack
+    if (lua_type(L, index) == LUA_TSTRING)
+    {
+        size_t length = 0;
+        char const* data = lua_tolstring(L, index, &length);
+        if ((offset + count) * sizeof(float) > length)
+            return false;
+        memcpy(output, data + offset * sizeof(float), count * sizeof(float));
+        return true;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        int type = lua_rawgeti(L, index, lua_Integer(offset + i + 1));
+        output[i] = float(lua_tonumber(L, -1));
+        lua_pop(L, 1);
+        if (type == LUA_TNIL)
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+static int lua_node_find(lua_State* L)
+{
+    // Arguments are checked before a reference is held, a raised error does not unwind C++ objects
+    char const* name = lua_isnoneornil(L, 1) ? nullptr : luaL_checkstring(L, 1);
+    BVH* bvh = BVH::Current;
+    xxNodePtr root = bvh ? bvh->root.lock() : nullptr;
+    if (root == nullptr || name == nullptr)
+    {
+        lua_pushnode(L, root);
+        return 1;
+    }
+    lua_pushnode(L, NodeTools::GetObject(root, name));
+    return 1;
 }
 //------------------------------------------------------------------------------
+static int lua_node_name(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    lua_pushstring(L, node->Name.c_str());
+    return 1;
+}
+//------------------------------------------------------------------------------
+static int lua_node_parent(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    lua_pushnode(L, node->GetParent());
+    return 1;
+}
+//------------------------------------------------------------------------------
+static int lua_node_children(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    lua_createtable(L, int(node->GetChildCount()), 0);
+    lua_Integer index = 0;
+    for (xxNodePtr const& child : (*node))
+    {
+        lua_pushnode(L, child);
+        lua_rawseti(L, -2, ++index);
+    }
+    return 1;
+}
+//------------------------------------------------------------------------------
+static int lua_node_get_matrix(lua_State* L)
+{
+    int magic = int(lua_tointeger(L, lua_upvalueindex(1)));
+    xxNode* node = lua_checknode(L, 1);
+    auto matrix = (float const*)(magic == 0 ? &node->LocalMatrix : &node->WorldMatrix);
+    luaL_checkstack(L, 16, nullptr);
+    for (int i = 0; i < 16; ++i)
+    {
+        lua_pushnumber(L, matrix[i]);
+    }
+    return 16;
+}
+//------------------------------------------------------------------------------
+static int lua_node_set_matrix(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    auto matrix = (float*)&node->LocalMatrix;
+    for (int i = 0; i < 16; ++i)
+    {
+        matrix[i] = float(luaL_checknumber(L, i + 2));
+    }
+    lua_marknode(node);
+    return 0;
+}
+//------------------------------------------------------------------------------
+static int lua_node_get_translate(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    xxVector4 const& translate = node->LocalMatrix.v[3];
+    lua_pushnumber(L, translate.x);
+    lua_pushnumber(L, translate.y);
+    lua_pushnumber(L, translate.z);
+    return 3;
+}
+//------------------------------------------------------------------------------
+static int lua_node_set_translate(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    xxVector4& translate = node->LocalMatrix.v[3];
+    translate.x = float(luaL_checknumber(L, 2));
+    translate.y = float(luaL_checknumber(L, 3));
+    translate.z = float(luaL_checknumber(L, 4));
+    lua_marknode(node);
+    return 0;
+}
+//------------------------------------------------------------------------------
+static int lua_node_modifier(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    if (lua_isnoneornil(L, 2))
+    {
+        lua_pushinteger(L, lua_Integer(node->Modifiers.size()));
+        return 1;
+    }
+    lua_Integer index = luaL_checkinteger(L, 2);
+    if (index < 1 || index > lua_Integer(node->Modifiers.size()) || node->Modifiers[index - 1].modifier == nullptr)
+        return 0;
+    xxModifier& modifier = *node->Modifiers[index - 1].modifier;
+    lua_pushstring(L, Modifier::Name(modifier).c_str());
+    lua_pushinteger(L, lua_Integer(modifier.DataType));
+    lua_pushinteger(L, lua_Integer(Modifier::Count(modifier)));
+    return 3;
+}
+//------------------------------------------------------------------------------
+static int lua_node_set_batch(lua_State* L)
+{
+    int magic = int(lua_tointeger(L, lua_upvalueindex(1)));
+    int stride = magic == 0 ? 16 : 3;
+    luaL_checktype(L, 1, LUA_TTABLE);
+    if (lua_type(L, 2) != LUA_TSTRING)
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+    // One call moves every node, values are read straight from the flat table or buffer
+    lua_Integer count = luaL_len(L, 1);
+    lua_Integer updated = 0;
+    for (lua_Integer i = 0; i < count; ++i)
+    {
+        lua_rawgeti(L, 1, i + 1);
+        xxNode* node = lua_tonode(L, -1);
+        lua_pop(L, 1);
+        float values[16];
+        if (lua_tofloats(L, 2, size_t(i * stride), values, stride) == false)
+            break;
+        if (node == nullptr)
+            continue;
+        if (magic == 0)
+            memcpy(&node->LocalMatrix, values, sizeof(values));
+        else
+            node->LocalMatrix.v[3].xyz = { values[0], values[1], values[2] };
+        lua_marknode(node);
+        updated++;
+    }
+    lua_pushinteger(L, updated);
+    return 1;
+}
+//------------------------------------------------------------------------------
+static int lua_node_get_batch(lua_State* L)
+{
+    int magic = int(lua_tointeger(L, lua_upvalueindex(1)));
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer count = luaL_len(L, 1);
+    if (lua_istable(L, 2))
+        lua_settop(L, 2);
+    else
+        lua_createtable(L, int(count * 16), 0);
+
+    // The output table is reused when it is given
+    lua_Integer index = 0;
+    for (lua_Integer i = 0; i < count; ++i)
+    {
+        lua_rawgeti(L, 1, i + 1);
+        xxNode* node = lua_tonode(L, -1);
+        lua_pop(L, 1);
+        auto matrix = (float const*)(node == nullptr ? &xxMatrix4::IDENTITY : magic == 0 ? &node->LocalMatrix : &node->WorldMatrix);
+        for (int j = 0; j < 16; ++j)
+        {
+            lua_pushnumber(L, matrix[j]);
+            lua_rawseti(L, -2, ++index);
+        }
+    }
+    return 1;
+}
+//==============================================================================
+//  Camera
+//==============================================================================
+static int lua_camera_get(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    xxCamera* camera = node->Camera.get();
+    if (camera == nullptr)
+        return 0;
+    xxVector3 const* vectors[4] = { &camera->Location, &camera->Direction, &camera->Up, &camera->Right };
+    luaL_checkstack(L, 12, nullptr);
+    for (xxVector3 const* vector : vectors)
+    {
+        lua_pushnumber(L, vector->x);
+        lua_pushnumber(L, vector->y);
+        lua_pushnumber(L, vector->z);
+    }
+    return 12;
+}
+//------------------------------------------------------------------------------
+static int lua_camera_set(lua_State* L)
+{
+    xxNode* node = lua_checknode(L, 1);
+    xxCamera* camera = node->Camera.get();
+    if (camera == nullptr)
+        return 0;
+    xxVector3* vectors[4] = { &camera->Location, &camera->Direction, &camera->Up, &camera->Right };
+    for (int i = 0; i < 4; ++i)
+    {
+        if (lua_isnoneornil(L, i * 3 + 2))
+            continue;
+        vectors[i]->x = float(luaL_checknumber(L, i * 3 + 2));
+        vectors[i]->y = float(luaL_checknumber(L, i * 3 + 3));
+        vectors[i]->z = float(luaL_checknumber(L, i * 3 + 4));
+    }
+    camera->Update();
+    return 0;
+}
+//==============================================================================
+//  Library
+//==============================================================================
 void Lua::RuntimeLibrary()
 {
+    static char const* const queries[] =
+    {
+        "QuerySphere",
+        "QueryBox",
+        "QueryRay",
+        "Pick",
+    };
+
+    lua_newtable(L);
+    for (int i = 0; i < 4; ++i)
+    {
+        lua_pushinteger(L, i);
+        lua_pushcclosure(L, lua_engine_query, 1);
+        lua_setfield(L, -2, queries[i]);
+    }
+    lua_pushcfunction(L, lua_engine_statistic);
+    lua_setfield(L, -2, "Statistic");
+    lua_setglobal(L, "Engine");
+
+    static luaL_Reg const nodes[] =
+    {
+        { "Find", lua_node_find },
+        { "Name", lua_node_name },
+        { "Parent", lua_node_parent },
+        { "Children", lua_node_children },
+        { "SetLocalMatrix", lua_node_set_matrix },
+        { "GetTranslate", lua_node_get_translate },
+        { "SetTranslate", lua_node_set_translate },
+        { "Modifier", lua_node_modifier },
+        { NULL, NULL }
+    };
+    static char const* const matrices[] =
+    {
+        "LocalMatrix",
+        "WorldMatrix",
+    };
+
+    lua_newtable(L);
+    luaL_setfuncs(L, nodes, 0);
+    for (int i = 0; i < 2; ++i)
+    {
+        lua_pushinteger(L, i);
+        lua_pushcclosure(L, lua_node_get_matrix, 1);
+        lua_setfield(L, -2, (std::string("Get") + matrices[i]).c_str());
+        lua_pushinteger(L, i);
+        lua_pushcclosure(L, lua_node_get_batch, 1);
+        lua_setfield(L, -2, (std::string("Get") + matrices[i] + "s").c_str());
+    }
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, lua_node_set_batch, 1);
+    lua_setfield(L, -2, "SetLocalMatrices");
+    lua_pushinteger(L, 1);
+    lua_pushcclosure(L, lua_node_set_batch, 1);
+    lua_setfield(L, -2, "SetTranslates");
+    lua_setglobal(L, "Node");
+
+    static luaL_Reg const cameras[] =
+    {
+        { "Get", lua_camera_get },
+        { "Set", lua_camera_set },
+        { NULL, NULL }
+    };
+
+    lua_newtable(L);
+    luaL_setfuncs(L, cameras, 0);
+    lua_setglobal(L, "Camera");
 }
 //------------------------------------------------------------------------------
 void Lua::Eval(char const* buf, size_t len)
@@ -6,6 +6,15 @@
 //==============================================================================
 #include "Runtime.h"
 #include <xxGraphicPlus/xxFile.h>
+#include <xxGraphicPlus/xxMaterial.h>
+#include <xxGraphicPlus/xxMesh.h>
+#include <xxGraphicPlus/xxModifier.h>
+#include <xxGraphicPlus/xxNode.h>
+#include <xxGraphicPlus/xxTexture.h>
+#include "Graphic/Resource.h"
+#include "Graphic/Texture.h"
+#include "Tools/BVH.h"
+#include "Tools/NodeTools.h"
 #include "QuickJS.h"
 
 extern "C"
@@ -21,6 +30,8 @@ extern "C"
 #endif
 }
 
+static void js_engine_view_check(JSContext* ctx);
+//------------------------------------------------------------------------------
 JSRuntime* QuickJS::rt;
 JSContext* QuickJS::ctx;
 void (*QuickJS::dump_error)(struct JSContext*);
@@ -62,6 +73,8 @@ void QuickJS::RuntimeLibrary()
 //------------------------------------------------------------------------------
 void QuickJS::Eval(char const* buf, size_t len)
 {
+    js_engine_view_check(ctx);
+
     JSValue val = JS_Eval(ctx, buf, len, "<QuickJS>", JS_EVAL_TYPE_MODULE);
     if (JS_IsException(val))
     {
@@ -74,6 +87,8 @@ void QuickJS::Eval(char const* buf, size_t len)
 //------------------------------------------------------------------------------
 void QuickJS::Update()
 {
+    js_engine_view_check(ctx);
+
     for (int i = 0; i < 1000; ++i)
     {
         JSContext* ctx1;
@@ -172,6 +187,248 @@ static JSValue js_engine_file_func(JSContext* ctx, JSValueConst this_val, int ar
     return JS_EXCEPTION;
 }
 //------------------------------------------------------------------------------
+static JSValue js_engine_query(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic)
+{
+    double args[6] = {};
+    for (int i = 0; i < argc && i < 6; ++i)
+    {
+        if (JS_ToFloat64(ctx, &args[i], argv[i]))
+            return JS_EXCEPTION;
+    }
+    BVH* bvh = BVH::Current;
+    if (magic == 3)
+    {
+        xxNodePtr node = bvh ? bvh->Pick({ float(args[0]), float(args[1]), float(args[2]) }, { float(args[3]), float(args[4]), float(args[5]) }) : nullptr;
+        return node ? JS_NewString(ctx, node->Name.c_str()) : JS_NULL;
+    }
+    JSValue array = JS_NewArray(ctx);
+    if (JS_IsException(array) || bvh == nullptr)
+        return array;
+    uint32_t index = 0;
+    auto callback = [&](xxNodePtr const& node)
+    {
+        JS_SetPropertyUint32(ctx, array, index++, JS_NewString(ctx, node->Name.c_str()));
+    };
+    switch (magic)
+    {
+    case 0:
+        bvh->QuerySphere({ float(args[0]), float(args[1]), float(args[2]), float(args[3]) }, callback);
+        break;
+    case 1:
+        bvh->QueryBox({ float(args[0]), float(args[1]), float(args[2]) }, { float(args[3]), float(args[4]), float(args[5]) }, callback);
+        break;
+    case 2:
+        bvh->QueryRay({ float(args[0]), float(args[1]), float(args[2]) }, { float(args[3]), float(args[4]), float(args[5]) }, [&](xxNodePtr const& node, float) { callback(node); });
+        break;
+    default:
+        break;
+    }
+    return array;
+}
+//------------------------------------------------------------------------------
+static JSValue js_engine_statistic(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv)
+{
+    JSValue object = JS_NewObject(ctx);
+    if (JS_IsException(object))
+        return object;
+    for (int i = 0; i < Resource::TYPE_COUNT; ++i)
+    {
+        Resource::Statistic const& statistic = Resource::Get(Resource::Type(i));
+        JSValue value = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, value, "count", JS_NewInt64(ctx, int64_t(statistic.count)));
+        JS_SetPropertyStr(ctx, value, "bytes", JS_NewInt64(ctx, int64_t(statistic.bytes)));
+        JS_SetPropertyStr(ctx, value, "created", JS_NewInt64(ctx, int64_t(statistic.created)));
+        JS_SetPropertyStr(ctx, value, "hit", JS_NewInt64(ctx, int64_t(statistic.hit)));
+        JS_SetPropertyStr(ctx, value, "miss", JS_NewInt64(ctx, int64_t(statistic.miss)));
+        JS_SetPropertyStr(ctx, value, "pending", JS_NewInt64(ctx, int64_t(statistic.pending)));
+        JS_SetPropertyStr(ctx, object, Resource::Name(Resource::Type(i)), value);
+    }
+    return object;
+}
+//==============================================================================
+//  Engine Memory
+//==============================================================================
+static xxNodePtr js_engine_node(JSContext* ctx, JSValueConst value)
+{
+    BVH* bvh = BVH::Current;
+    xxNodePtr root = bvh ? bvh->root.lock() : nullptr;
+    if (root == nullptr)
+        return nullptr;
+    char const* name = JS_ToCString(ctx, value);
+    if (name == nullptr)
+        return nullptr;
+    xxNodePtr node = NodeTools::GetObject(root, name);
+    JS_FreeCString(ctx, name);
+    return node;
+}
+//------------------------------------------------------------------------------
+struct js_engine_view_data
+{
+    std::shared_ptr<void> owner;
+    std::function<std::pair<void*, size_t>()> source;
+    void* data;
+    size_t size;
+    JSValue buffer;
+};
+static std::vector<js_engine_view_data*> js_engine_views;
+//------------------------------------------------------------------------------
+static JSValue js_engine_view(JSContext* ctx, std::shared_ptr<void> owner, std::function<std::pair<void*, size_t>()> source)
+{
+    auto [data, size] = source();
+    if (owner == nullptr || data == nullptr || size == 0)
+        return JS_NULL;
+
+    // The buffer shares the memory of the engine and keeps its owner alive until it is collected or detached
+    auto view = new js_engine_view_data{ std::move(owner), std::move(source), data, size, JS_UNDEFINED };
+    auto free = [](JSRuntime*, void* opaque, void* data)
+    {
+        // The finalizer of a detached buffer is called again without data
+        if (data == nullptr)
+            return;
+        auto view = (js_engine_view_data*)opaque;
+        js_engine_views.erase(std::find(js_engine_views.begin(), js_engine_views.end(), view));
+        delete view;
+    };
+    JSValue buffer = JS_NewArrayBuffer(ctx, (uint8_t*)data, size, free, view, 0);
+    if (JS_IsException(buffer))
+    {
+        delete view;
+        return buffer;
+    }
+    view->buffer = buffer;
+    js_engine_views.push_back(view);
+    return buffer;
+}
+//------------------------------------------------------------------------------
+static void js_engine_view_check(JSContext* ctx)
+{
+    // Views of a resized or reallocated memory are detached before the script can run again
+    std::vector<JSValue> expired;
+    for (js_engine_view_data* view : js_engine_views)
+    {
+        auto [data, size] = view->source();
+        if (view->data != data || view->size != size)
+            expired.push_back(view->buffer);
+    }
+    for (JSValue buffer : expired)
+    {
+        JS_DetachArrayBuffer(ctx, buffer);
+    }
+}
+//------------------------------------------------------------------------------
+static JSValue js_engine_mesh(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic)
+{
+    xxNodePtr node = js_engine_node(ctx, argv[0]);
+    xxMeshPtr mesh = node ? node->Mesh : nullptr;
+    if (mesh == nullptr)
+        return JS_NULL;
+
+    // Views are detached when the mesh is resized
+    int vertexCount = mesh->Count[xxMesh::VERTEX];
+    int indexSize = vertexCount < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+    switch (magic)
+    {
+    case 0:
+        return js_engine_view(ctx, mesh, [mesh = mesh.get()]() -> std::pair<void*, size_t>
+        {
+            return { mesh->Vertex, size_t(mesh->Count[xxMesh::VERTEX]) * mesh->VertexStride };
+        });
+    case 1:
+        return js_engine_view(ctx, mesh, [mesh = mesh.get()]() -> std::pair<void*, size_t>
+        {
+            int indexSize = mesh->Count[xxMesh::VERTEX] < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+            return { mesh->Index, size_t(mesh->Count[xxMesh::INDEX]) * indexSize };
+        });
+    case 2:
+    {
+        int32_t slot = 0;
+        if (JS_ToInt32(ctx, &slot, argv[1]))
+            return JS_EXCEPTION;
+        slot += xxMesh::STORAGE0;
+        if (slot < xxMesh::STORAGE0 || slot >= int32_t(xxCountOf(mesh->Storage)))
+            return JS_NULL;
+        return js_engine_view(ctx, mesh, [mesh = mesh.get(), slot]() -> std::pair<void*, size_t>
+        {
+            return { mesh->Storage[slot], size_t(mesh->Count[slot]) * mesh->Stride[slot] };
+        });
+    }
+    case 3:
+    {
+        JSValue object = JS_NewObject(ctx);
+        if (JS_IsException(object))
+            return object;
+        JS_SetPropertyStr(ctx, object, "vertexCount", JS_NewInt32(ctx, vertexCount));
+        JS_SetPropertyStr(ctx, object, "vertexStride", JS_NewInt32(ctx, mesh->VertexStride));
+        JS_SetPropertyStr(ctx, object, "indexCount", JS_NewInt32(ctx, mesh->Count[xxMesh::INDEX]));
+        JS_SetPropertyStr(ctx, object, "indexSize", JS_NewInt32(ctx, indexSize));
+        JS_SetPropertyStr(ctx, object, "normalCount", JS_NewInt32(ctx, mesh->NormalCount));
+        JS_SetPropertyStr(ctx, object, "colorCount", JS_NewInt32(ctx, mesh->ColorCount));
+        JS_SetPropertyStr(ctx, object, "textureCount", JS_NewInt32(ctx, mesh->TextureCount));
+        JS_SetPropertyStr(ctx, object, "skinning", JS_NewBool(ctx, mesh->Skinning));
+        return object;
+    }
+    case 4:
+        mesh->Invalidate();
+        mesh->CalculateBound();
+        return JS_UNDEFINED;
+    default:
+        break;
+    }
+    return JS_EXCEPTION;
+}
+//------------------------------------------------------------------------------
+static JSValue js_engine_modifier(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv)
+{
+    xxNodePtr node = js_engine_node(ctx, argv[0]);
+    int32_t index = 0;
+    if (JS_ToInt32(ctx, &index, argv[1]))
+        return JS_EXCEPTION;
+    if (node == nullptr || index < 0 || index >= int32_t(node->Modifiers.size()))
+        return JS_NULL;
+    xxModifierPtr const& modifier = node->Modifiers[index].modifier;
+    if (modifier == nullptr)
+        return JS_NULL;
+    return js_engine_view(ctx, modifier, [modifier = modifier.get()]() -> std::pair<void*, size_t>
+    {
+        return { modifier->Data.data(), modifier->Data.size() };
+    });
+}
+//------------------------------------------------------------------------------
+static JSValue js_engine_texture(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic)
+{
+    xxNodePtr node = js_engine_node(ctx, argv[0]);
+    int32_t stage = 0;
+    int32_t mipmap = 0;
+    if (JS_ToInt32(ctx, &stage, argv[1]))
+        return JS_EXCEPTION;
+    if (magic == 0 && argc > 2 && JS_ToInt32(ctx, &mipmap, argv[2]))
+        return JS_EXCEPTION;
+    xxMaterialPtr material = node ? node->Material : nullptr;
+    if (material == nullptr || stage < 0 || stage >= int32_t(material->Textures.size()))
+        return JS_NULL;
+    xxTexturePtr const& texture = material->Textures[stage];
+    if (texture == nullptr || (*texture)() == nullptr)
+        return JS_NULL;
+    if (magic == 1)
+    {
+        texture->Invalidate();
+        return JS_UNDEFINED;
+    }
+    if (mipmap < 0 || mipmap >= texture->Mipmap)
+        return JS_NULL;
+
+    // The first array slice of the level, compressed formats are exposed as blocks
+    return js_engine_view(ctx, texture, [texture = texture.get(), mipmap]() -> std::pair<void*, size_t>
+    {
+        if (mipmap >= texture->Mipmap)
+            return { nullptr, 0 };
+        int width = std::max(texture->Width >> mipmap, 1);
+        int height = std::max(texture->Height >> mipmap, 1);
+        int depth = std::max(texture->Depth >> mipmap, 1);
+        return { (*texture)(0, 0, 0, mipmap), Texture::Calculate(texture->Format, width, height, depth) };
+    });
+}
+//------------------------------------------------------------------------------
 JSModuleDef* js_init_module_engine(JSContext* ctx)
 {
     static JSCFunctionListEntry const js_engine_funcs[] =
@@ -182,6 +439,19 @@ JSModuleDef* js_init_module_engine(JSContext* ctx)
         JS_CFUNC_DEF("Log", 0, js_engine_log),
         JS_CFUNC_MAGIC_DEF("FileLoad", 1, js_engine_file, 0),
         JS_CFUNC_MAGIC_DEF("FileSave", 1, js_engine_file, 1),
+        JS_CFUNC_MAGIC_DEF("QuerySphere", 4, js_engine_query, 0),
+        JS_CFUNC_MAGIC_DEF("QueryBox", 6, js_engine_query, 1),
+        JS_CFUNC_MAGIC_DEF("QueryRay", 6, js_engine_query, 2),
+        JS_CFUNC_MAGIC_DEF("Pick", 6, js_engine_query, 3),
+        JS_CFUNC_DEF("Statistic", 0, js_engine_statistic),
+        JS_CFUNC_MAGIC_DEF("MeshVertex", 1, js_engine_mesh, 0),
+        JS_CFUNC_MAGIC_DEF("MeshIndex", 1, js_engine_mesh, 1),
+        JS_CFUNC_MAGIC_DEF("MeshStorage", 2, js_engine_mesh, 2),
+        JS_CFUNC_MAGIC_DEF("MeshInfo", 1, js_engine_mesh, 3),
+        JS_CFUNC_MAGIC_DEF("MeshInvalidate", 1, js_engine_mesh, 4),
+        JS_CFUNC_DEF("ModifierData", 2, js_engine_modifier),
+        JS_CFUNC_MAGIC_DEF("TextureData", 3, js_engine_texture, 0),
+        JS_CFUNC_MAGIC_DEF("TextureInvalidate", 2, js_engine_texture, 1),
     };
 
     auto js_engine_init = [](JSContext* ctx, JSModuleDef* m)
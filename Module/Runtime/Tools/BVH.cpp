@@ -0,0 +1,505 @@
+//==============================================================================
+// Minamoto : BVH Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <float.h>
+#include <xxGraphicPlus/xxNode.h>
+#if HAVE_MINIGUI
+#include <MiniGUI/Window.h>
+#endif
+#include "DrawTools.h"
+#include "NodeTools.h"
+#include "BVH.h"
+
+BVH* BVH::Current = nullptr;
+//==============================================================================
+static xxVector3 Minimum(xxVector3 const& a, xxVector3 const& b)
+{
+    return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) };
+}
+//------------------------------------------------------------------------------
+static xxVector3 Maximum(xxVector3 const& a, xxVector3 const& b)
+{
+    return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) };
+}
+//------------------------------------------------------------------------------
+static float Perimeter(xxVector3 const& minimum, xxVector3 const& maximum)
+{
+    xxVector3 size = maximum - minimum;
+    return size.x + size.y + size.z;
+}
+//------------------------------------------------------------------------------
+static bool Contain(BVH::Node const& node, xxVector3 const& minimum, xxVector3 const& maximum)
+{
+    return node.minimum.x <= minimum.x && node.minimum.y <= minimum.y && node.minimum.z <= minimum.z &&
+           node.maximum.x >= maximum.x && node.maximum.y >= maximum.y && node.maximum.z >= maximum.z;
+}
+//------------------------------------------------------------------------------
+static bool Overlap(BVH::Node const& node, xxVector3 const& minimum, xxVector3 const& maximum)
+{
+    return node.minimum.x <= maximum.x && node.minimum.y <= maximum.y && node.minimum.z <= maximum.z &&
+           node.maximum.x >= minimum.x && node.maximum.y >= minimum.y && node.maximum.z >= minimum.z;
+}
+//------------------------------------------------------------------------------
+static float Distance(xxVector3 const& minimum, xxVector3 const& maximum, xxVector3 const& point)
+{
+    xxVector3 closest = Maximum(minimum, Minimum(maximum, point));
+    return (closest - point).Length();
+}
+//------------------------------------------------------------------------------
+static int Frustum(xxMatrix4x2 const* frustum, BVH::Node const& node)
+{
+    xxVector3 center = (node.maximum + node.minimum) * 0.5f;
+    xxVector3 extent = (node.maximum - node.minimum) * 0.5f;
+    int result = 1;
+    for (int i = 0; i < 6; ++i)
+    {
+        xxVector3 const& normal = frustum[i].v[0].xyz;
+        float distance = normal.Dot(center - frustum[i].v[1].xyz);
+        float radius = std::fabs(normal.x) * extent.x + std::fabs(normal.y) * extent.y + std::fabs(normal.z) * extent.z;
+        if (distance < -radius)
+            return -1;
+        if (distance < radius)
+            result = 0;
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+static bool Ray(BVH::Node const& node, xxVector3 const& origin, xxVector3 const& inverse)
+{
+    xxVector3 lower = node.minimum - origin;
+    xxVector3 upper = node.maximum - origin;
+    xxVector3 t0 = { lower.x * inverse.x, lower.y * inverse.y, lower.z * inverse.z };
+    xxVector3 t1 = { upper.x * inverse.x, upper.y * inverse.y, upper.z * inverse.z };
+    xxVector3 minimum = Minimum(t0, t1);
+    xxVector3 maximum = Maximum(t0, t1);
+    float enter = std::max(std::max(minimum.x, minimum.y), std::max(minimum.z, 0.0f));
+    float leave = std::min(std::min(maximum.x, maximum.y), maximum.z);
+    return enter <= leave;
+}
+//------------------------------------------------------------------------------
+static bool Ray(xxVector4 const& bound, xxVector3 const& origin, xxVector3 const& direction, float& distance)
+{
+    xxVector3 offset = bound.xyz - origin;
+    float center = offset.Dot(direction);
+    float square = offset.Dot(offset) - center * center;
+    float radius = bound.w * bound.w;
+    if (square > radius)
+        return false;
+    float half = std::sqrt(radius - square);
+    distance = center - half;
+    if (distance < 0.0f)
+        distance = center + half;
+    return distance >= 0.0f;
+}
+//------------------------------------------------------------------------------
+static void Collect(xxNodePtr const& node, std::vector<xxNodePtr>& meshes)
+{
+#if HAVE_MINIGUI
+    if (node->Flags & MiniGUI::Window::WINDOW_CLASS)
+        return;
+#endif
+    if (node->Mesh)
+        meshes.push_back(node);
+    for (xxNodePtr const& child : (*node))
+        Collect(child, meshes);
+}
+//==============================================================================
+void BVH::Clear()
+{
+    nodes.clear();
+    leaves.clear();
+    trunks.clear();
+    root.reset();
+    revision = SIZE_MAX;
+    rootIndex = -1;
+    freeIndex = -1;
+}
+//------------------------------------------------------------------------------
+void BVH::Update(xxNodePtr const& node)
+{
+    if (root.lock() != node)
+    {
+        Clear();
+        root = node;
+    }
+    if (node == nullptr)
+        return;
+
+    // Membership is refreshed only for the trunks updated by NodeTools since the last revision
+    size_t current = NodeTools::GetRevision(node);
+    if (revision != current)
+    {
+        revision = current;
+
+        std::unordered_set<xxNode*> changed;
+        for (auto it = trunks.begin(); it != trunks.end();)
+        {
+            xxNodePtr trunk = (*it).second.node.lock();
+            if (trunk == nullptr || trunk->GetParent() != node)
+            {
+                changed.insert((*it).first);
+                it = trunks.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        std::vector<xxNodePtr> meshes;
+        for (xxNodePtr const& child : (*node))
+        {
+            size_t trunkRevision = NodeTools::GetRevision(node, child);
+            Trunk& trunk = trunks[child.get()];
+            if (trunk.node.lock() == child && trunk.revision == trunkRevision)
+                continue;
+            trunk.node = child;
+            trunk.revision = trunkRevision;
+            changed.insert(child.get());
+        }
+        if (changed.empty() == false)
+        {
+            for (auto it = leaves.begin(); it != leaves.end();)
+            {
+                int leaf = (*it).second;
+                if (changed.find(nodes[leaf].trunk) != changed.end())
+                {
+                    RemoveLeaf(leaf);
+                    Release(leaf);
+                    it = leaves.erase(it);
+                    continue;
+                }
+                ++it;
+            }
+            for (xxNodePtr const& child : (*node))
+            {
+                if (changed.find(child.get()) == changed.end())
+                    continue;
+                meshes.clear();
+                Collect(child, meshes);
+                for (xxNodePtr const& mesh : meshes)
+                {
+                    auto [it, inserted] = leaves.emplace(mesh.get(), -1);
+                    if (inserted == false)
+                    {
+                        nodes[(*it).second].trunk = child.get();
+                        continue;
+                    }
+                    int leaf = Allocate();
+                    nodes[leaf].node = mesh;
+                    nodes[leaf].trunk = child.get();
+                    nodes[leaf].minimum = xxVector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+                    nodes[leaf].maximum = xxVector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+                    (*it).second = leaf;
+                }
+            }
+        }
+    }
+
+    // Leaves are reinserted only when they escape their fattened box
+    for (auto it = leaves.begin(); it != leaves.end();)
+    {
+        int leaf = (*it).second;
+        xxNodePtr mesh = nodes[leaf].node.lock();
+        if (mesh == nullptr)
+        {
+            RemoveLeaf(leaf);
+            Release(leaf);
+            it = leaves.erase(it);
+            continue;
+        }
+        SetLeaf(leaf, mesh->WorldBound);
+        ++it;
+    }
+}
+//------------------------------------------------------------------------------
+size_t BVH::GetLeafCount() const
+{
+    return leaves.size();
+}
+//------------------------------------------------------------------------------
+size_t BVH::QueryFrustum(xxMatrix4x2 const* frustum, std::function<void(xxNodePtr const&)> const& callback) const
+{
+    size_t count = 0;
+    if (rootIndex < 0)
+        return count;
+    std::vector<std::pair<int, bool>> stack = { { rootIndex, false } };
+    while (stack.empty() == false)
+    {
+        auto [index, inside] = stack.back();
+        stack.pop_back();
+        Node const& node = nodes[index];
+        if (inside == false)
+        {
+            int result = Frustum(frustum, node);
+            if (result < 0)
+                continue;
+            inside = result > 0;
+        }
+        if (node.children[0] < 0)
+        {
+            xxNodePtr mesh = node.node.lock();
+            if (mesh == nullptr || (inside == false && DrawTools::Visible(frustum, mesh->WorldBound) == false))
+                continue;
+            callback(mesh);
+            count++;
+            continue;
+        }
+        stack.push_back({ node.children[0], inside });
+        stack.push_back({ node.children[1], inside });
+    }
+    return count;
+}
+//------------------------------------------------------------------------------
+size_t BVH::QuerySphere(xxVector4 const& sphere, std::function<void(xxNodePtr const&)> const& callback) const
+{
+    size_t count = 0;
+    if (rootIndex < 0)
+        return count;
+    std::vector<int> stack = { rootIndex };
+    while (stack.empty() == false)
+    {
+        Node const& node = nodes[stack.back()];
+        stack.pop_back();
+        if (Distance(node.minimum, node.maximum, sphere.xyz) > sphere.w)
+            continue;
+        if (node.children[0] < 0)
+        {
+            xxNodePtr mesh = node.node.lock();
+            if (mesh == nullptr || (mesh->WorldBound.xyz - sphere.xyz).Length() > mesh->WorldBound.w + sphere.w)
+                continue;
+            callback(mesh);
+            count++;
+            continue;
+        }
+        stack.push_back(node.children[0]);
+        stack.push_back(node.children[1]);
+    }
+    return count;
+}
+//------------------------------------------------------------------------------
+size_t BVH::QueryBox(xxVector3 const& minimum, xxVector3 const& maximum, std::function<void(xxNodePtr const&)> const& callback) const
+{
+    size_t count = 0;
+    if (rootIndex < 0)
+        return count;
+    std::vector<int> stack = { rootIndex };
+    while (stack.empty() == false)
+    {
+        Node const& node = nodes[stack.back()];
+        stack.pop_back();
+        if (Overlap(node, minimum, maximum) == false)
+            continue;
+        if (node.children[0] < 0)
+        {
+            xxNodePtr mesh = node.node.lock();
+            if (mesh == nullptr || Distance(minimum, maximum, mesh->WorldBound.xyz) > mesh->WorldBound.w)
+                continue;
+            callback(mesh);
+            count++;
+            continue;
+        }
+        stack.push_back(node.children[0]);
+        stack.push_back(node.children[1]);
+    }
+    return count;
+}
+//------------------------------------------------------------------------------
+size_t BVH::QueryRay(xxVector3 const& origin, xxVector3 const& direction, std::function<void(xxNodePtr const&, float distance)> const& callback) const
+{
+    size_t count = 0;
+    if (rootIndex < 0)
+        return count;
+    float length = direction.Length();
+    if (length <= FLT_EPSILON || std::isfinite(length) == false)
+        return count;
+    xxVector3 normal = direction;
+    normal /= length;
+
+    // Axis-aligned rays keep a signed epsilon so the slab test never multiplies zero by infinity
+    auto reciprocal = [](float value)
+    {
+        if (std::fabs(value) < FLT_EPSILON)
+            value = std::signbit(value) ? -FLT_EPSILON : FLT_EPSILON;
+        return 1.0f / value;
+    };
+    xxVector3 inverse = { reciprocal(normal.x), reciprocal(normal.y), reciprocal(normal.z) };
+    std::vector<int> stack = { rootIndex };
+    while (stack.empty() == false)
+    {
+        Node const& node = nodes[stack.back()];
+        stack.pop_back();
+        if (Ray(node, origin, inverse) == false)
+            continue;
+        if (node.children[0] < 0)
+        {
+            float distance = 0.0f;
+            xxNodePtr mesh = node.node.lock();
+            if (mesh == nullptr || Ray(mesh->WorldBound, origin, normal, distance) == false)
+                continue;
+            callback(mesh, distance);
+            count++;
+            continue;
+        }
+        stack.push_back(node.children[0]);
+        stack.push_back(node.children[1]);
+    }
+    return count;
+}
+//------------------------------------------------------------------------------
+xxNodePtr BVH::Pick(xxVector3 const& origin, xxVector3 const& direction) const
+{
+    xxNodePtr output;
+    float nearest = FLT_MAX;
+    QueryRay(origin, direction, [&](xxNodePtr const& node, float distance)
+    {
+        if (nearest > distance)
+        {
+            nearest = distance;
+            output = node;
+        }
+    });
+    return output;
+}
+//------------------------------------------------------------------------------
+int BVH::Allocate()
+{
+    int index = freeIndex;
+    if (index < 0)
+    {
+        index = int(nodes.size());
+        nodes.emplace_back();
+    }
+    else
+    {
+        freeIndex = nodes[index].parent;
+    }
+    Node& node = nodes[index];
+    node.parent = -1;
+    node.children[0] = -1;
+    node.children[1] = -1;
+    node.node.reset();
+    node.trunk = nullptr;
+    return index;
+}
+//------------------------------------------------------------------------------
+void BVH::Release(int index)
+{
+    nodes[index].node.reset();
+    nodes[index].parent = freeIndex;
+    freeIndex = index;
+}
+//------------------------------------------------------------------------------
+void BVH::InsertLeaf(int leaf)
+{
+    if (rootIndex < 0)
+    {
+        rootIndex = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    // Descend towards the sibling with the smallest perimeter increase
+    xxVector3 minimum = nodes[leaf].minimum;
+    xxVector3 maximum = nodes[leaf].maximum;
+    int index = rootIndex;
+    while (nodes[index].children[0] >= 0)
+    {
+        Node const& node = nodes[index];
+        float area = Perimeter(node.minimum, node.maximum);
+        float combined = Perimeter(Minimum(node.minimum, minimum), Maximum(node.maximum, maximum));
+        float cost = 2.0f * combined;
+        float inherit = 2.0f * (combined - area);
+        float costs[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            Node const& child = nodes[node.children[i]];
+            costs[i] = Perimeter(Minimum(child.minimum, minimum), Maximum(child.maximum, maximum)) + inherit;
+            if (child.children[0] >= 0)
+                costs[i] -= Perimeter(child.minimum, child.maximum);
+        }
+        if (cost < costs[0] && cost < costs[1])
+            break;
+        index = node.children[costs[0] < costs[1] ? 0 : 1];
+    }
+
+    int sibling = index;
+    int parent = Allocate();
+    int grand = nodes[sibling].parent;
+    nodes[parent].parent = grand;
+    nodes[parent].children[0] = sibling;
+    nodes[parent].children[1] = leaf;
+    nodes[sibling].parent = parent;
+    nodes[leaf].parent = parent;
+    if (grand < 0)
+    {
+        rootIndex = parent;
+    }
+    else
+    {
+        Node& node = nodes[grand];
+        node.children[node.children[0] == sibling ? 0 : 1] = parent;
+    }
+    Refit(parent);
+}
+//------------------------------------------------------------------------------
+void BVH::RemoveLeaf(int leaf)
+{
+    if (rootIndex == leaf)
+    {
+        rootIndex = -1;
+        return;
+    }
+    int parent = nodes[leaf].parent;
+    if (parent < 0)
+        return;
+
+    int grand = nodes[parent].parent;
+    int sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+    nodes[sibling].parent = grand;
+    nodes[leaf].parent = -1;
+    if (grand < 0)
+    {
+        rootIndex = sibling;
+    }
+    else
+    {
+        Node& node = nodes[grand];
+        node.children[node.children[0] == parent ? 0 : 1] = sibling;
+        Refit(grand);
+    }
+    Release(parent);
+}
+//------------------------------------------------------------------------------
+void BVH::Refit(int index)
+{
+    while (index >= 0)
+    {
+        Node& node = nodes[index];
+        Node const& left = nodes[node.children[0]];
+        Node const& right = nodes[node.children[1]];
+        node.minimum = Minimum(left.minimum, right.minimum);
+        node.maximum = Maximum(left.maximum, right.maximum);
+        index = node.parent;
+    }
+}
+//------------------------------------------------------------------------------
+bool BVH::SetLeaf(int leaf, xxVector4 const& bound)
+{
+    float radius = std::max(bound.w, 0.0f);
+    xxVector3 extent = { radius, radius, radius };
+    xxVector3 minimum = bound.xyz - extent;
+    xxVector3 maximum = bound.xyz + extent;
+    Node& node = nodes[leaf];
+    if (Contain(node, minimum, maximum))
+        return false;
+
+    RemoveLeaf(leaf);
+    xxVector3 margin = extent * 0.25f + xxVector3{ 0.1f, 0.1f, 0.1f };
+    node.minimum = minimum - margin;
+    node.maximum = maximum + margin;
+    InsertLeaf(leaf);
+    return true;
+}
+//==============================================================================
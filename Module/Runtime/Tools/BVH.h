@@ -0,0 +1,59 @@
+//==============================================================================
+// Minamoto : BVH Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+struct RuntimeAPI BVH
+{
+    struct Node
+    {
+        xxVector3               minimum;
+        xxVector3               maximum;
+        int                     parent;
+        int                     children[2];
+        std::weak_ptr<xxNode>   node;
+        xxNode*                 trunk;
+    };
+
+    struct Trunk
+    {
+        std::weak_ptr<xxNode>   node;
+        size_t                  revision;
+    };
+
+    std::vector<Node>                   nodes;
+    std::unordered_map<xxNode*, int>    leaves;
+    std::unordered_map<xxNode*, Trunk>  trunks;
+    std::weak_ptr<xxNode>               root;
+    size_t                              revision = SIZE_MAX;
+    int                                 rootIndex = -1;
+    int                                 freeIndex = -1;
+
+    void Clear();
+    void Update(xxNodePtr const& root);
+    size_t GetLeafCount() const;
+
+    size_t QueryFrustum(xxMatrix4x2 const* frustum, std::function<void(xxNodePtr const&)> const& callback) const;
+    size_t QuerySphere(xxVector4 const& sphere, std::function<void(xxNodePtr const&)> const& callback) const;
+    size_t QueryBox(xxVector3 const& minimum, xxVector3 const& maximum, std::function<void(xxNodePtr const&)> const& callback) const;
+    size_t QueryRay(xxVector3 const& origin, xxVector3 const& direction, std::function<void(xxNodePtr const&, float distance)> const& callback) const;
+    xxNodePtr Pick(xxVector3 const& origin, xxVector3 const& direction) const;
+
+    static BVH* Current;
+
+protected:
+    int Allocate();
+    void Release(int index);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void Refit(int index);
+    bool SetLeaf(int leaf, xxVector4 const& bound);
+};
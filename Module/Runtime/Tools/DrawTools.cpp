@@ -5,18 +5,74 @@
 // https://github.com/metarutaiga/minamoto
 //==============================================================================
 #include "Runtime.h"
+#include <unordered_map>
 #include <xxGraphicPlus/xxCamera.h>
+#include <xxGraphicPlus/xxMaterial.h>
 #include <xxGraphicPlus/xxMesh.h>
 #include <xxGraphicPlus/xxNode.h>
 #if HAVE_MINIGUI
+#include <MiniGUI/Batch.h>
 #include <MiniGUI/Window.h>
 #endif
+#include "Graphic/Material.h"
+#include "BVH.h"
+#include "LightTools.h"
+#include "LODTools.h"
+#include "OcclusionTools.h"
+#include "SkinningTools.h"
 #include "DrawTools.h"
 
+//==============================================================================
+struct DrawItem
+{
+    uint64_t key;
+    xxNode* node;
+    xxMeshPtr const* mesh;
+};
+static std::vector<DrawItem> drawQueue;
+static std::vector<DrawItem> drawSwap;
+static std::unordered_map<uint64_t, uint64_t> drawPipelines;
+static std::unordered_map<void*, uint64_t> drawTextures;
+static std::unordered_map<uint64_t, uint64_t> drawBatches;
+static std::vector<xxNode*> drawInstances;
+static bool drawQueueing = false;
+//------------------------------------------------------------------------------
+static uint64_t SortField(uint64_t value, uint64_t limit, size_t& overflow)
+{
+    // Identifiers past the field share the last value, which only weakens the grouping
+    if (value <= limit)
+        return value;
+    overflow++;
+    return limit;
+}
+//------------------------------------------------------------------------------
+static void RadixSort(std::vector<DrawItem>& items, std::vector<DrawItem>& swap)
+{
+    swap.resize(items.size());
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (DrawItem const& item : items)
+            counts[(item.key >> shift) & 0xFF]++;
+        if (counts[(items.front().key >> shift) & 0xFF] == items.size())
+            continue;
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t value = count;
+            count = offset;
+            offset += value;
+        }
+        for (DrawItem const& item : items)
+            swap[counts[(item.key >> shift) & 0xFF]++] = item;
+        items.swap(swap);
+    }
+}
 //==============================================================================
 void DrawTools::Draw(DrawData& drawData, xxNodePtr const& node)
 {
     xxMatrix4x2 frustum[6];
+    xxMatrix4x2 const* previousFrustum = drawData.frustum;
     if (drawData.camera3D)
     {
         drawData.camera = drawData.camera3D.get();
@@ -27,24 +83,249 @@ void DrawTools::Draw(DrawData& drawData, xxNodePtr const& node)
         }
     }
 
+    if (drawData.camera3D && drawQueueing == false)
+        LightTools::Build(drawData.camera3D.get());
+
+    bool sort = drawData.sort && drawData.camera3D && drawQueueing == false;
+    if (sort)
+    {
+        drawQueueing = true;
+        drawQueue.clear();
+    }
+
     if (node->Mesh)
-        node->Draw(drawData);
+        DrawNode(drawData, node.get());
 
+    bool hierarchy = true;
+    if (drawData.frustum && drawData.bvh && drawData.bvh->root.lock() == node)
+    {
+        size_t visible = drawData.bvh->QueryFrustum(drawData.frustum, [&](xxNodePtr const& node)
+        {
+            DrawNode(drawData, node.get());
+        });
+        drawData.culledCount += drawData.bvh->GetLeafCount() - visible;
+        hierarchy = false;
+    }
+
+#if HAVE_MINIGUI
+    std::vector<MiniGUI::WindowPtr> windows;
+#endif
     for (xxNodePtr const& child : (*node))
     {
 #if HAVE_MINIGUI
         auto window = MiniGUI::Window::Cast(child);
         if (window)
         {
-            xxCamera* camera = drawData.camera;
-            drawData.camera = drawData.camera2D.get();
-            DrawTraversal(drawData, window);
-            drawData.camera = camera;
+            windows.push_back(window);
             continue;
         }
 #endif
-        DrawTraversal(drawData, child);
+        if (hierarchy == false)
+            continue;
+        if (drawData.frustum)
+            DrawCullingTraversal(drawData, child);
+        else
+            DrawTraversal(drawData, child);
+    }
+
+    if (sort)
+    {
+        drawQueueing = false;
+        DrawQueue(drawData);
+    }
+
+#if HAVE_MINIGUI
+    if (windows.empty() == false)
+    {
+        xxCamera* camera = drawData.camera;
+        drawData.camera = drawData.camera2D.get();
+        MiniGUI::Batch::Draw(drawData, windows);
+        drawData.camera = camera;
+    }
+#endif
+
+    drawData.frustum = previousFrustum;
+}
+//------------------------------------------------------------------------------
+bool DrawTools::Visible(xxMatrix4x2 const* frustum, xxVector4 const& bound)
+{
+    if (bound.w <= 0.0f)
+        return true;
+    for (int i = 0; i < 6; ++i)
+    {
+        xxMatrix4x2 const& plane = frustum[i];
+        float distance = plane.v[0].xyz.Dot(bound.xyz - plane.v[1].xyz);
+        if (distance < -bound.w)
+            return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void DrawTools::DrawNode(DrawData& drawData, xxNode* node)
+{
+    xxMeshPtr const* mesh = &node->Mesh;
+    if (drawData.lodError > 0.0f && drawData.camera == drawData.camera3D.get())
+        mesh = &LODTools::Select(node, drawData.camera, drawData.lodError);
+    if (drawQueueing)
+    {
+        drawQueue.push_back({ 0, node, mesh });
+        return;
+    }
+    if (SkinningTools::Software(node, *mesh))
+        mesh = &SkinningTools::Skin(node, *mesh);
+    DrawMesh(drawData, node, *mesh);
+}
+//------------------------------------------------------------------------------
+void DrawTools::DrawMesh(DrawData& drawData, xxNode* node, xxMeshPtr const& mesh)
+{
+    if (mesh == node->Mesh)
+    {
+        node->Draw(drawData);
+        return;
+    }
+    xxMeshPtr base = node->Mesh;
+    node->Mesh = mesh;
+    if (base->Skinning && mesh->Skinning == false)
+    {
+        // Software skinned vertices are already in world space
+        xxMatrix4 world = node->WorldMatrix;
+        node->WorldMatrix = xxMatrix4::IDENTITY;
+        node->Draw(drawData);
+        node->WorldMatrix = world;
+    }
+    else
+    {
+        node->Draw(drawData);
+    }
+    node->Mesh = base;
+}
+//------------------------------------------------------------------------------
+void DrawTools::DrawQueue(DrawData& drawData)
+{
+    if (drawQueue.empty())
+        return;
+
+    xxCamera* camera = drawData.camera3D.get();
+    if (drawData.occlusion)
+    {
+        OcclusionTools::Begin(camera);
+        for (DrawItem const& item : drawQueue)
+        {
+            if (OcclusionTools::Occluder(item.node))
+                OcclusionTools::Rasterize(item.node, item.node->Mesh);
+        }
+        OcclusionTools::Finish();
+
+        size_t count = drawQueue.size();
+        drawQueue.erase(std::remove_if(drawQueue.begin(), drawQueue.end(), [](DrawItem const& item)
+        {
+            return OcclusionTools::Visible(item.node->WorldBound) == false;
+        }), drawQueue.end());
+        drawData.occludedCount += count - drawQueue.size();
+        if (drawQueue.empty())
+            return;
+    }
+
+    // Occluded nodes are not deformed
+    for (DrawItem& item : drawQueue)
+    {
+        if (SkinningTools::Software(item.node, *item.mesh))
+            item.mesh = &SkinningTools::Skin(item.node, *item.mesh, true);
+    }
+    SkinningTools::Finish();
+
+    // Only pairs of mesh and material drawn more than once by instancing get a batch
+    for (DrawItem const& item : drawQueue)
+    {
+        xxMaterial* material = item.node->Material.get();
+        if (material == nullptr || material->Blending || Material::InstanceAvailable(item.node) == false)
+            continue;
+        uint64_t key = uint64_t(material) ^ (uint64_t(item.mesh->get()) << 16);
+        auto& batch = drawBatches[key];
+        if (batch == 0)
+            batch = drawBatches.size() << 1;
+        else
+            batch |= 1;
+    }
+
+    // Opaque   : 0 | pipeline:12 | texture:12 | batch:15 | front-to-back depth:24
+    // Blending : 1 | back-to-front depth:24 | pipeline:12 | texture:12 | batch:15
+    for (DrawItem& item : drawQueue)
+    {
+        xxNode* node = item.node;
+        xxMaterial* material = node->Material.get();
+        uint64_t pipeline = 0;
+        uint64_t texture = 0;
+        uint64_t batch = 0;
+        bool blending = false;
+        if (material)
+        {
+            uint64_t handle = Material::GetPipeline(material);
+            pipeline = drawPipelines.emplace(handle ? handle : uint64_t(material), drawPipelines.size()).first->second;
+            pipeline = SortField(pipeline, 0xFFF, drawData.sortOverflowCount);
+            if (material->Textures.empty() == false)
+            {
+                texture = drawTextures.emplace(material->Textures.front().get(), drawTextures.size()).first->second;
+                texture = SortField(texture, 0xFFF, drawData.sortOverflowCount);
+            }
+            auto it = drawBatches.find(uint64_t(material) ^ (uint64_t(item.mesh->get()) << 16));
+            if (it != drawBatches.end() && (it->second & 1))
+                batch = SortField(it->second >> 1, 0x7FFF, drawData.sortOverflowCount);
+            blending = material->Blending;
+        }
+
+        float depth = std::max(camera->Direction.Dot(node->WorldBound.xyz - camera->Location), 0.0f);
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        uint64_t distance = bits >> 7;
+
+        if (blending)
+            item.key = (uint64_t(1) << 63) | ((0xFFFFFF - distance) << 39) | (pipeline << 27) | (texture << 15) | batch;
+        else
+            item.key = (pipeline << 51) | (texture << 39) | (batch << 24) | distance;
     }
+    drawPipelines.clear();
+    drawTextures.clear();
+    drawBatches.clear();
+
+    RadixSort(drawQueue, drawSwap);
+    for (size_t i = 0; i < drawQueue.size(); ++i)
+    {
+        xxNode* node = drawQueue[i].node;
+        xxMeshPtr const& mesh = *drawQueue[i].mesh;
+
+        // Merge consecutive opaque draws sharing a mesh and a material
+        drawInstances.clear();
+        drawInstances.push_back(node);
+        if (Material::InstanceAvailable(node) && node->Material->Blending == false)
+        {
+            while (i + 1 < drawQueue.size() && drawInstances.size() < size_t(Material::INSTANCE_MAX))
+            {
+                xxNode* next = drawQueue[i + 1].node;
+                if (*drawQueue[i + 1].mesh != mesh || next->Material != node->Material || Material::InstanceAvailable(next) == false)
+                    break;
+                drawInstances.push_back(next);
+                i++;
+            }
+        }
+        if (drawInstances.size() == 1)
+        {
+            DrawMesh(drawData, node, mesh);
+            continue;
+        }
+
+        Material::SetInstance(drawInstances.data(), int(drawInstances.size()));
+        DrawMesh(drawData, node, mesh);
+        bool instanced = Material::GetInstance() != 0;
+        Material::SetInstance(nullptr, 0);
+        if (instanced)
+            continue;
+        for (size_t j = 1; j < drawInstances.size(); ++j)
+        {
+            DrawMesh(drawData, drawInstances[j], mesh);
+        }
+    }
+    drawQueue.clear();
 }
 //------------------------------------------------------------------------------
 void DrawTools::DrawTraversal(DrawData& drawData, xxNodePtr const& node)
@@ -52,8 +333,23 @@ void DrawTools::DrawTraversal(DrawData& drawData, xxNodePtr const& node)
     if (node == nullptr)
         return;
     if (node->Mesh)
-        node->Draw(drawData);
+        DrawNode(drawData, node.get());
     for (xxNodePtr const& child : (*node))
         DrawTraversal(drawData, child);
 }
+//------------------------------------------------------------------------------
+void DrawTools::DrawCullingTraversal(DrawData& drawData, xxNodePtr const& node)
+{
+    if (node == nullptr)
+        return;
+    if (Visible(drawData.frustum, node->WorldBound) == false)
+    {
+        drawData.culledCount++;
+        return;
+    }
+    if (node->Mesh)
+        DrawNode(drawData, node.get());
+    for (xxNodePtr const& child : (*node))
+        DrawCullingTraversal(drawData, child);
+}
 //==============================================================================
@@ -12,9 +12,21 @@ struct RuntimeAPI DrawTools
     {
         xxCameraPtr     camera2D;
         xxCameraPtr     camera3D;
+        struct BVH*     bvh = nullptr;
+        size_t          culledCount = 0;
+        size_t          occludedCount = 0;
+        size_t          sortOverflowCount = 0;
+        float           lodError = 0.0f;
+        bool            occlusion = false;
+        bool            sort = false;
     };
 
     static void Draw(DrawData& drawData, xxNodePtr const& node);
+    static bool Visible(xxMatrix4x2 const* frustum, xxVector4 const& bound);
 protected:
+    static void DrawNode(DrawData& drawData, xxNode* node);
+    static void DrawMesh(DrawData& drawData, xxNode* node, xxMeshPtr const& mesh);
+    static void DrawQueue(DrawData& drawData);
     static void DrawTraversal(DrawData& drawData, xxNodePtr const& node);
+    static void DrawCullingTraversal(DrawData& drawData, xxNodePtr const& node);
 };
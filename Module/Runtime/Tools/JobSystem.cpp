@@ -0,0 +1,163 @@
+//==============================================================================
+// Minamoto : JobSystem Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "JobSystem.h"
+
+//==============================================================================
+struct Job
+{
+    std::function<void(size_t)> const* function;
+    std::atomic<size_t>* remain;
+    size_t index;
+};
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+static std::vector<std::thread> threads;
+static std::unique_ptr<JobQueue[]> queues;
+static size_t queueCount = 0;
+static std::atomic<size_t> pending;
+static std::mutex sleepMutex;
+static std::condition_variable sleepCondition;
+static bool running = false;
+static thread_local size_t threadIndex = 0;
+//------------------------------------------------------------------------------
+static bool Pop(size_t index, Job& job)
+{
+    JobQueue& queue = queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+//------------------------------------------------------------------------------
+static bool Steal(size_t index, Job& job)
+{
+    for (size_t i = 1; i < queueCount; ++i)
+    {
+        JobQueue& queue = queues[(index + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+static bool Execute(size_t index)
+{
+    Job job;
+    if (Pop(index, job) == false && Steal(index, job) == false)
+        return false;
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    (*job.function)(job.index);
+    job.remain->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+//------------------------------------------------------------------------------
+static void Worker(size_t index)
+{
+    threadIndex = index;
+    for (;;)
+    {
+        if (Execute(index))
+            continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, []{ return running == false || pending.load(std::memory_order_relaxed) != 0; });
+        if (running == false)
+            break;
+    }
+}
+//==============================================================================
+void JobSystem::Initialize(size_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+    if (running && queueCount == threadCount)
+        return;
+    Shutdown();
+
+    queues = std::unique_ptr<JobQueue[]>(new JobQueue[threadCount]);
+    queueCount = threadCount;
+    running = true;
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(Worker, i);
+    }
+
+    xxLog("JobSystem", "Thread : %zu", threadCount);
+}
+//------------------------------------------------------------------------------
+void JobSystem::Shutdown()
+{
+    if (running == false)
+        return;
+
+    sleepMutex.lock();
+    running = false;
+    sleepMutex.unlock();
+    sleepCondition.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+    queues = nullptr;
+    queueCount = 0;
+}
+//------------------------------------------------------------------------------
+size_t JobSystem::GetThreadCount()
+{
+    return queueCount ? queueCount : 1;
+}
+//------------------------------------------------------------------------------
+void JobSystem::Dispatch(size_t count, std::function<void(size_t index)> const& function)
+{
+    if (count == 0)
+        return;
+    if (queueCount <= 1 || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    std::atomic<size_t> remain = { count };
+    pending.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < queueCount; ++i)
+    {
+        JobQueue& queue = queues[(threadIndex + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t j = i; j < count; j += queueCount)
+        {
+            queue.jobs.push_back({ &function, &remain, j });
+        }
+    }
+    sleepMutex.lock();
+    sleepMutex.unlock();
+    sleepCondition.notify_all();
+
+    while (remain.load(std::memory_order_acquire) != 0)
+    {
+        if (Execute(threadIndex) == false)
+            std::this_thread::yield();
+    }
+}
+//==============================================================================
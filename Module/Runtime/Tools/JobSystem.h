@@ -0,0 +1,18 @@
+//==============================================================================
+// Minamoto : JobSystem Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+#include <functional>
+
+struct RuntimeAPI JobSystem
+{
+    static void Initialize(size_t threadCount = 0);
+    static void Shutdown();
+    static size_t GetThreadCount();
+    static void Dispatch(size_t count, std::function<void(size_t index)> const& function);
+};
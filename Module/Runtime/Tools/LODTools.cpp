@@ -0,0 +1,235 @@
+//==============================================================================
+// Minamoto : LODTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <unordered_map>
+#include <xxGraphicPlus/xxCamera.h>
+#include <xxGraphicPlus/xxMesh.h>
+#include <xxGraphicPlus/xxNode.h>
+#include "LODTools.h"
+
+// Storage : magic | level count | { index offset, index count, error } * level count | indices
+static constexpr int LOD_STORAGE = xxMesh::STORAGE2 + 1;
+static_assert(LOD_STORAGE < std::extent_v<decltype(xxMesh::Count)> && LOD_STORAGE < std::extent_v<decltype(xxMesh::Storage)>);
+static constexpr uint32_t LOD_MAGIC = 0x4C4F4431;
+static constexpr float LOD_HYSTERESIS = 0.75f;
+
+//==============================================================================
+struct LODChain
+{
+    std::weak_ptr<xxMesh> mesh;
+    void const* storage = nullptr;
+    std::vector<xxMeshPtr> levels;
+    std::vector<float> errors;
+};
+struct LODState
+{
+    int level;
+    uint32_t frame;
+};
+static std::unordered_map<xxMesh*, LODChain> chains;
+static std::unordered_map<xxCamera const*, std::unordered_map<xxNode const*, LODState>> states;
+static uint32_t frame = 0;
+//------------------------------------------------------------------------------
+static xxMeshPtr CreateLevel(xxMeshPtr const& mesh, uint32_t const* indices, uint32_t count)
+{
+    int vertexCount = mesh->Count[xxMesh::VERTEX];
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> outputIndices(count);
+    uint32_t unique = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t index = indices[i];
+        if (index >= uint32_t(vertexCount))
+            return nullptr;
+        if (remap[index] == UINT32_MAX)
+            remap[index] = unique++;
+        outputIndices[i] = remap[index];
+    }
+
+    xxMeshPtr output = xxMesh::Create(mesh->Skinning, mesh->NormalCount, mesh->ColorCount, mesh->TextureCount);
+    if (output == nullptr || output->VertexStride != mesh->VertexStride)
+        return nullptr;
+    output->Name = mesh->Name;
+    output->SetVertexCount(static_cast<int>(unique));
+    output->SetIndexCount(static_cast<int>(count));
+
+    int stride = mesh->VertexStride;
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        if (remap[i] == UINT32_MAX)
+            continue;
+        memcpy((char*)output->Vertex + remap[i] * stride, (char*)mesh->Vertex + i * stride, stride);
+    }
+    if (output->Count[xxMesh::VERTEX] < 65536)
+    {
+        auto index = (uint16_t*)output->Index;
+        for (uint32_t i = 0; i < count; ++i)
+            (*index++) = uint16_t(outputIndices[i]);
+    }
+    else
+    {
+        memcpy(output->Index, outputIndices.data(), count * sizeof(uint32_t));
+    }
+    output->CalculateBound();
+
+    return output;
+}
+//------------------------------------------------------------------------------
+static LODChain const* GetChain(xxMeshPtr const& mesh)
+{
+    static LODChain const empty;
+    if (mesh == nullptr || mesh->Count[LOD_STORAGE] < 2 || mesh->Stride[LOD_STORAGE] != sizeof(uint32_t))
+        return &empty;
+
+    // Meshlet storages only describe the base level
+    if (mesh->Count[xxMesh::STORAGE0] && mesh->Count[xxMesh::STORAGE1] && mesh->Count[xxMesh::STORAGE2])
+        return &empty;
+
+    LODChain& chain = chains[mesh.get()];
+    if (chain.mesh.lock() == mesh && chain.storage == mesh->Storage[LOD_STORAGE])
+        return &chain;
+
+    chain = LODChain();
+    chain.mesh = mesh;
+    chain.storage = mesh->Storage[LOD_STORAGE];
+    chain.levels.push_back(mesh);
+    chain.errors.push_back(0.0f);
+
+    auto storage = (uint32_t const*)mesh->Storage[LOD_STORAGE];
+    uint32_t size = uint32_t(mesh->Count[LOD_STORAGE]);
+    if (storage[0] != LOD_MAGIC || storage[1] * 3 + 2 > size)
+        return &chain;
+    for (uint32_t i = 0; i < storage[1]; ++i)
+    {
+        uint32_t offset = storage[2 + i * 3 + 0];
+        uint32_t count = storage[2 + i * 3 + 1];
+        float error;
+        memcpy(&error, &storage[2 + i * 3 + 2], sizeof(float));
+        if (count == 0 || offset > size || count > size - offset)
+            break;
+        xxMeshPtr level = CreateLevel(mesh, storage + offset, count);
+        if (level == nullptr)
+            break;
+        chain.levels.push_back(level);
+        chain.errors.push_back(error);
+    }
+
+    return &chain;
+}
+//==============================================================================
+int LODTools::GetLevelCount(xxMeshPtr const& mesh)
+{
+    return int(GetChain(mesh)->levels.size());
+}
+//------------------------------------------------------------------------------
+float LODTools::GetLevelError(xxMeshPtr const& mesh, int level)
+{
+    LODChain const* chain = GetChain(mesh);
+    if (level < 0 || level >= int(chain->errors.size()))
+        return 0.0f;
+    return chain->errors[level];
+}
+//------------------------------------------------------------------------------
+xxMeshPtr const& LODTools::GetLevel(xxMeshPtr const& mesh, int level)
+{
+    LODChain const* chain = GetChain(mesh);
+    if (level <= 0 || level >= int(chain->levels.size()))
+        return mesh;
+    return chain->levels[level];
+}
+//------------------------------------------------------------------------------
+void LODTools::SetLevels(xxMeshPtr const& mesh, std::vector<std::vector<uint32_t>> const& levels, std::vector<float> const& errors)
+{
+    if (mesh == nullptr || levels.size() != errors.size())
+        return;
+
+    std::vector<uint32_t> storage;
+    storage.push_back(LOD_MAGIC);
+    storage.push_back(uint32_t(levels.size()));
+    size_t offset = 2 + levels.size() * 3;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        uint32_t error;
+        memcpy(&error, &errors[i], sizeof(uint32_t));
+        storage.push_back(uint32_t(offset));
+        storage.push_back(uint32_t(levels[i].size()));
+        storage.push_back(error);
+        offset += levels[i].size();
+    }
+    for (auto const& indices : levels)
+    {
+        storage.insert(storage.end(), indices.begin(), indices.end());
+    }
+
+    if (levels.empty())
+        storage.clear();
+    mesh->SetStorageCount(LOD_STORAGE, static_cast<int>(storage.size()), xxSizeOf(uint32_t));
+    if (storage.size())
+        memcpy(mesh->Storage[LOD_STORAGE], storage.data(), storage.size() * sizeof(uint32_t));
+    chains.erase(mesh.get());
+}
+//------------------------------------------------------------------------------
+xxMeshPtr const& LODTools::Select(xxNode* node, xxCamera* camera, float threshold)
+{
+    xxMeshPtr const& mesh = node->Mesh;
+    if (camera == nullptr || threshold <= 0.0f)
+        return mesh;
+    LODChain const* chain = GetChain(mesh);
+    int count = int(chain->levels.size());
+    if (count <= 1)
+        return mesh;
+
+    // Projected error in screen heights, scaled by the extent of the bound
+    xxVector4 const& bound = node->WorldBound;
+    float distance = camera->Direction.Dot(bound.xyz - camera->Location) - bound.w;
+    float height = distance * (camera->FrustumTop - camera->FrustumBottom);
+    float scale = height > 0.0f ? 2.0f * bound.w / height : 0.0f;
+
+    // Every camera keeps its own hysteresis
+    LODState& state = states[camera].emplace(node, LODState{ 0, frame }).first->second;
+    int level = std::min(state.level, count - 1);
+    if (scale == 0.0f)
+        level = 0;
+    while (level > 0 && chain->errors[level] * scale > threshold)
+        level--;
+    while (level + 1 < count && scale > 0.0f && chain->errors[level + 1] * scale <= threshold * LOD_HYSTERESIS)
+        level++;
+    state.level = level;
+    state.frame = frame;
+
+    return chain->levels[level];
+}
+//------------------------------------------------------------------------------
+void LODTools::Flush()
+{
+    frame++;
+    if ((frame & 63) != 0)
+        return;
+    for (auto it = states.begin(); it != states.end(); )
+    {
+        auto& nodes = it->second;
+        for (auto node = nodes.begin(); node != nodes.end(); )
+        {
+            if (frame - node->second.frame > 64)
+                node = nodes.erase(node);
+            else
+                ++node;
+        }
+        if (nodes.empty())
+            it = states.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = chains.begin(); it != chains.end(); )
+    {
+        if (it->second.mesh.expired())
+            it = chains.erase(it);
+        else
+            ++it;
+    }
+}
+//==============================================================================
@@ -0,0 +1,19 @@
+//==============================================================================
+// Minamoto : LODTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI LODTools
+{
+    static int GetLevelCount(xxMeshPtr const& mesh);
+    static float GetLevelError(xxMeshPtr const& mesh, int level);
+    static xxMeshPtr const& GetLevel(xxMeshPtr const& mesh, int level);
+    static void SetLevels(xxMeshPtr const& mesh, std::vector<std::vector<uint32_t>> const& levels, std::vector<float> const& errors);
+    static xxMeshPtr const& Select(xxNode* node, xxCamera* camera, float threshold);
+    static void Flush();
+};
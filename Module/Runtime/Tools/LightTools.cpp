@@ -0,0 +1,261 @@
+//==============================================================================
+// Minamoto : LightTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <xxGraphicPlus/xxCamera.h>
+#include "JobSystem.h"
+#include "LightTools.h"
+
+static constexpr uint32_t LIGHT_LIFETIME = 1;
+
+//==============================================================================
+struct LightEntry
+{
+    LightTools::Light light;
+    uint32_t frame;
+};
+struct LightView
+{
+    float x;
+    float y;
+    float z;
+    float range;
+};
+struct ClusterGrid
+{
+    float left;
+    float bottom;
+    float scaleX;
+    float scaleY;
+    float sliceScale;
+    float sliceBias;
+};
+static std::mutex lightMutex;
+static std::unordered_map<void const*, LightEntry> lightEntries;
+static std::vector<std::pair<float, LightTools::Light>> lightCandidates;
+static LightView lightViews[LightTools::LIGHT_MAX];
+static int lightViewCount = 0;
+static uint32_t lightMasks[LightTools::CLUSTER_COUNT];
+static xxVector4 lightConstant[LightTools::CONSTANT_COUNT];
+static ClusterGrid grid;
+static xxCamera const* buildCamera = nullptr;
+static xxMatrix4 buildView;
+static xxMatrix4 buildProjection;
+static bool lightChanged = true;
+static uint32_t frame = 0;
+static uint32_t serial = 0;
+//------------------------------------------------------------------------------
+size_t LightTools::LightCount;
+size_t LightTools::ClusterCount;
+//------------------------------------------------------------------------------
+static float SliceDepth(int slice)
+{
+    return expf((slice - grid.sliceBias) / grid.sliceScale);
+}
+//------------------------------------------------------------------------------
+static void AssignSlice(int slice)
+{
+    uint32_t* masks = lightMasks + slice * LightTools::CLUSTER_X * LightTools::CLUSTER_Y;
+    memset(masks, 0, LightTools::CLUSTER_X * LightTools::CLUSTER_Y * sizeof(uint32_t));
+
+    float sliceNear = SliceDepth(slice);
+    float sliceFar = SliceDepth(slice + 1);
+    for (int i = 0; i < lightViewCount; ++i)
+    {
+        LightView const& view = lightViews[i];
+        float depthNear = std::max(view.z - view.range, sliceNear);
+        float depthFar = std::min(view.z + view.range, sliceFar);
+        if (depthNear > depthFar)
+            continue;
+
+        // The box of the sphere projects to its extremes at the nearest or farthest depth of the slice
+        float minX = std::min((view.x - view.range) / depthNear, (view.x - view.range) / depthFar);
+        float maxX = std::max((view.x + view.range) / depthNear, (view.x + view.range) / depthFar);
+        float minY = std::min((view.y - view.range) / depthNear, (view.y - view.range) / depthFar);
+        float maxY = std::max((view.y + view.range) / depthNear, (view.y + view.range) / depthFar);
+        int x0 = int(std::max((minX - grid.left) * grid.scaleX, 0.0f));
+        int x1 = int(floorf(std::min((maxX - grid.left) * grid.scaleX, float(LightTools::CLUSTER_X - 1))));
+        int y0 = int(std::max((minY - grid.bottom) * grid.scaleY, 0.0f));
+        int y1 = int(floorf(std::min((maxY - grid.bottom) * grid.scaleY, float(LightTools::CLUSTER_Y - 1))));
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                masks[y * LightTools::CLUSTER_X + x] |= 1u << i;
+            }
+        }
+    }
+}
+//==============================================================================
+bool LightTools::Available()
+{
+    // Shader model 2 and OpenGL ES 2.0 have no integer bit operations
+    char const* deviceString = xxGetInstanceName();
+    return strstr(deviceString, "Metal") || strstr(deviceString, "Direct3D 1") || strstr(deviceString, "Vulkan");
+}
+//------------------------------------------------------------------------------
+void LightTools::Add(void const* key, Light const& light)
+{
+    std::lock_guard<std::mutex> lock(lightMutex);
+    LightEntry& entry = lightEntries[key];
+    if (memcmp(&entry.light, &light, sizeof(Light)) != 0)
+    {
+        entry.light = light;
+        lightChanged = true;
+    }
+    entry.frame = frame;
+}
+//------------------------------------------------------------------------------
+void LightTools::Build(xxCamera const* camera)
+{
+    // Draws sharing a camera reuse the clusters until the camera or a light changes
+    if (camera && camera == buildCamera && lightChanged == false)
+    {
+        if (memcmp(&buildView, &camera->ViewMatrix, sizeof(xxMatrix4)) == 0 &&
+            memcmp(&buildProjection, &camera->ProjectionMatrix, sizeof(xxMatrix4)) == 0)
+            return;
+    }
+    serial++;
+    buildCamera = camera;
+    if (camera == nullptr)
+        return;
+    buildView = camera->ViewMatrix;
+    buildProjection = camera->ProjectionMatrix;
+
+    float frustumNear = std::max(camera->FrustumNear, 0.001f);
+    float frustumFar = std::max(camera->FrustumFar, frustumNear * 2.0f);
+    grid.left = camera->FrustumLeft;
+    grid.bottom = camera->FrustumBottom;
+    grid.scaleX = CLUSTER_X / (camera->FrustumRight - camera->FrustumLeft);
+    grid.scaleY = CLUSTER_Y / (camera->FrustumTop - camera->FrustumBottom);
+    grid.sliceScale = CLUSTER_Z / logf(frustumFar / frustumNear);
+    grid.sliceBias = -logf(frustumNear) * grid.sliceScale;
+
+    xxVector4* constant = lightConstant;
+    constant[0].xyz = camera->Right;
+    constant[0].w = grid.scaleX;
+    constant[1].xyz = camera->Up;
+    constant[1].w = grid.scaleY;
+    constant[2].xyz = camera->Direction;
+    constant[2].w = frustumNear;
+    constant[3].x = -grid.left * grid.scaleX;
+    constant[3].y = -grid.bottom * grid.scaleY;
+    constant[3].z = grid.sliceScale;
+    constant[3].w = grid.sliceBias;
+    constant += 4;
+
+    // Lights outside of the depth range are skipped, the nearest ones are kept
+    lightCandidates.clear();
+    {
+        std::lock_guard<std::mutex> lock(lightMutex);
+        lightChanged = false;
+        for (auto const& [key, entry] : lightEntries)
+        {
+            if (frame - entry.frame > LIGHT_LIFETIME)
+                continue;
+            Light const& light = entry.light;
+            float z = camera->Direction.Dot(light.position - camera->Location);
+            if (light.range <= 0.0f || z + light.range < frustumNear || z - light.range > frustumFar)
+                continue;
+            lightCandidates.push_back({ (light.position - camera->Location).Length() - light.range, light });
+        }
+    }
+    if (lightCandidates.size() > LIGHT_MAX)
+    {
+        std::partial_sort(lightCandidates.begin(), lightCandidates.begin() + LIGHT_MAX, lightCandidates.end(), [](auto const& a, auto const& b)
+        {
+            return a.first < b.first;
+        });
+        lightCandidates.resize(LIGHT_MAX);
+    }
+
+    lightViewCount = int(lightCandidates.size());
+    memset(constant, 0, LIGHT_MAX * 3 * sizeof(xxVector4));
+    for (int i = 0; i < lightViewCount; ++i)
+    {
+        Light const& light = lightCandidates[i].second;
+        xxVector3 vector = light.position - camera->Location;
+        lightViews[i].x = camera->Right.Dot(vector);
+        lightViews[i].y = camera->Up.Dot(vector);
+        lightViews[i].z = camera->Direction.Dot(vector);
+        lightViews[i].range = light.range;
+
+        // Cone : saturate(dot(-L, direction) * scale + offset), point lights have no cone
+        float scale = 0.0f;
+        float offset = 1.0f;
+        xxVector3 direction = xxVector3::ZERO;
+        if (light.outerAngle > 0.0f)
+        {
+            float cosOuter = cosf(light.outerAngle * float(M_PI / 180.0));
+            float cosInner = cosf(std::min(light.innerAngle, light.outerAngle) * float(M_PI / 180.0));
+            scale = 1.0f / std::max(cosInner - cosOuter, 0.001f);
+            offset = -cosOuter * scale;
+            direction = light.direction;
+            direction /= std::max(direction.Length(), 0.0001f);
+        }
+        constant[i * 3 + 0].xyz = light.position;
+        constant[i * 3 + 0].w = 1.0f / light.range;
+        constant[i * 3 + 1].xyz = light.color;
+        constant[i * 3 + 1].w = scale;
+        constant[i * 3 + 2].xyz = direction;
+        constant[i * 3 + 2].w = offset;
+    }
+    constant += LIGHT_MAX * 3;
+
+    if (lightViewCount)
+    {
+        JobSystem::Dispatch(CLUSTER_Z, [](size_t index)
+        {
+            AssignSlice(int(index));
+        });
+    }
+    else
+    {
+        memset(lightMasks, 0, sizeof(lightMasks));
+    }
+    memcpy(constant, lightMasks, sizeof(lightMasks));
+
+    LightCount += lightViewCount;
+    for (uint32_t mask : lightMasks)
+    {
+        if (mask)
+            ClusterCount++;
+    }
+}
+//------------------------------------------------------------------------------
+void LightTools::Flush()
+{
+    frame++;
+
+    // Lights are submitted by every update, the ones which are not submitted any more are removed
+    std::lock_guard<std::mutex> lock(lightMutex);
+    for (auto it = lightEntries.begin(); it != lightEntries.end(); )
+    {
+        if (frame - it->second.frame > LIGHT_LIFETIME)
+        {
+            it = lightEntries.erase(it);
+            lightChanged = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+xxVector4 const* LightTools::GetConstant()
+{
+    return lightConstant;
+}
+//------------------------------------------------------------------------------
+uint32_t LightTools::GetSerial()
+{
+    return serial;
+}
+//==============================================================================
@@ -0,0 +1,41 @@
+//==============================================================================
+// Minamoto : LightTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI LightTools
+{
+    struct Light
+    {
+        xxVector3 position;
+        float range;
+        xxVector3 color;
+        float innerAngle;
+        xxVector3 direction;
+        float outerAngle;
+    };
+
+    static constexpr int LIGHT_MAX = 32;
+    static constexpr int CLUSTER_X = 16;
+    static constexpr int CLUSTER_Y = 8;
+    static constexpr int CLUSTER_Z = 16;
+    static constexpr int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+    // Constant : camera basis * 4 | { position, color, direction } * LIGHT_MAX | light masks * CLUSTER_COUNT
+    static constexpr int CONSTANT_COUNT = 4 + LIGHT_MAX * 3 + CLUSTER_COUNT / 4;
+
+    static bool Available();
+    static void Add(void const* key, Light const& light);
+    static void Build(xxCamera const* camera);
+    static void Flush();
+    static xxVector4 const* GetConstant();
+    static uint32_t GetSerial();
+
+    static size_t LightCount;
+    static size_t ClusterCount;
+};
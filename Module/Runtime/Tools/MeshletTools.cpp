@@ -0,0 +1,161 @@
+//==============================================================================
+// Minamoto : MeshletTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <unordered_map>
+#include <xxGraphicPlus/xxMesh.h>
+#include "MeshletTools.h"
+
+//==============================================================================
+struct MeshletIndex
+{
+    void const* storage;
+    void const* index;
+    int indexCount;
+    bool ordered;
+    std::vector<int> firstIndex;
+};
+static std::unordered_map<xxMesh const*, MeshletIndex> meshletIndices;
+static std::vector<int> meshletRanges;
+size_t MeshletTools::TotalCount;
+size_t MeshletTools::CulledCount;
+//------------------------------------------------------------------------------
+static MeshletIndex const& GetMeshletIndex(xxMesh const* mesh)
+{
+    MeshletIndex& index = meshletIndices[mesh];
+    if (index.storage == mesh->Storage[xxMesh::STORAGE0] && index.index == mesh->Index && index.indexCount == mesh->Count[xxMesh::INDEX])
+        return index;
+
+    index.storage = mesh->Storage[xxMesh::STORAGE0];
+    index.index = mesh->Index;
+    index.indexCount = mesh->Count[xxMesh::INDEX];
+    index.ordered = false;
+    index.firstIndex.clear();
+
+    // The index buffer must list the triangles meshlet by meshlet
+    auto meshlets = (MeshletTools::Meshlet const*)mesh->Storage[xxMesh::STORAGE0];
+    auto vertices = (uint32_t const*)mesh->Storage[xxMesh::STORAGE1];
+    auto triangles = (uint32_t const*)mesh->Storage[xxMesh::STORAGE2];
+    int vertexCount = mesh->Count[xxMesh::STORAGE1];
+    int triangleCount = mesh->Count[xxMesh::STORAGE2];
+    bool bits16 = mesh->Count[xxMesh::VERTEX] < 65536;
+    int first = 0;
+    for (int i = 0; i < mesh->Count[xxMesh::STORAGE0]; ++i)
+    {
+        MeshletTools::Meshlet const& meshlet = meshlets[i];
+        if (int(meshlet.triangleOffset + meshlet.triangleCount) > triangleCount)
+            return index;
+        if (first + int(meshlet.triangleCount) * 3 > index.indexCount)
+            return index;
+        index.firstIndex.push_back(first);
+        for (uint32_t j = 0; j < meshlet.triangleCount; ++j)
+        {
+            uint32_t triangle = triangles[meshlet.triangleOffset + j];
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t local = meshlet.vertexOffset + ((triangle >> (k * 8)) & 0xFF);
+                if (int(local) >= vertexCount)
+                    return index;
+                uint32_t expected = vertices[local];
+                uint32_t actual = bits16 ? ((uint16_t const*)mesh->Index)[first] : ((uint32_t const*)mesh->Index)[first];
+                if (expected != actual)
+                    return index;
+                first++;
+            }
+        }
+    }
+    index.firstIndex.push_back(first);
+    index.ordered = true;
+    return index;
+}
+//==============================================================================
+bool MeshletTools::Available(xxMesh const* mesh)
+{
+    if (mesh == nullptr || mesh->Index == nullptr)
+        return false;
+    if (mesh->Count[xxMesh::STORAGE0] == 0 || mesh->Count[xxMesh::STORAGE1] == 0 || mesh->Count[xxMesh::STORAGE2] == 0)
+        return false;
+    if (mesh->Stride[xxMesh::STORAGE0] != sizeof(Meshlet))
+        return false;
+    return GetMeshletIndex(mesh).ordered;
+}
+//------------------------------------------------------------------------------
+int const* MeshletTools::Cull(xxMesh const* mesh, xxMatrix4 const& world, xxMatrix4x2 const* frustum, xxVector3 const* eye, int& count)
+{
+    count = 0;
+    meshletRanges.clear();
+
+    MeshletIndex const& index = GetMeshletIndex(mesh);
+    if (index.ordered == false)
+        return nullptr;
+
+    xxVector3 const& x = world.v[0].xyz;
+    xxVector3 const& y = world.v[1].xyz;
+    xxVector3 const& z = world.v[2].xyz;
+    xxVector3 const& w = world.v[3].xyz;
+    float scale = std::max(std::max(x.Dot(x), y.Dot(y)), z.Dot(z));
+    scale = std::sqrt(scale);
+
+    auto meshlets = (Meshlet const*)mesh->Storage[xxMesh::STORAGE0];
+    int meshletCount = mesh->Count[xxMesh::STORAGE0];
+    for (int i = 0; i < meshletCount; ++i)
+    {
+        Meshlet const& meshlet = meshlets[i];
+        bool visible = true;
+
+        if (visible && eye)
+        {
+            xxVector4 const& a = meshlet.coneApex;
+            xxVector4 const& c = meshlet.coneAxisCutoff;
+            xxVector3 apex = x * a.x + y * a.y + z * a.z + w;
+            xxVector3 axis = x * c.x + y * c.y + z * c.z;
+            xxVector3 view = apex - (*eye);
+            float length = axis.Length() * view.Length();
+            if (length > 0.0f && axis.Dot(view) >= c.w * length)
+                visible = false;
+        }
+
+        if (visible && frustum)
+        {
+            xxVector4 const& s = meshlet.centerRadius;
+            xxVector3 center = x * s.x + y * s.y + z * s.z + w;
+            float radius = s.w * scale;
+            for (int j = 0; j < 6; ++j)
+            {
+                xxMatrix4x2 const& plane = frustum[j];
+                if (plane.v[0].xyz.Dot(center - plane.v[1].xyz) < -radius)
+                {
+                    visible = false;
+                    break;
+                }
+            }
+        }
+
+        if (visible == false)
+        {
+            CulledCount++;
+            continue;
+        }
+
+        // Merge with the previous range when contiguous
+        int first = index.firstIndex[i];
+        int size = index.firstIndex[i + 1] - first;
+        if (meshletRanges.size() && meshletRanges[meshletRanges.size() - 2] + meshletRanges.back() == first)
+        {
+            meshletRanges.back() += size;
+            continue;
+        }
+        meshletRanges.push_back(first);
+        meshletRanges.push_back(size);
+    }
+    TotalCount += meshletCount;
+
+    // Every meshlet may be culled, an empty list must not be mistaken for no culling
+    static int const empty[2] = {};
+    count = int(meshletRanges.size() / 2);
+    return count ? meshletRanges.data() : empty;
+}
+//==============================================================================
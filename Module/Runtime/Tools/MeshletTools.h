@@ -0,0 +1,29 @@
+//==============================================================================
+// Minamoto : MeshletTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI MeshletTools
+{
+    struct Meshlet
+    {
+        uint32_t vertexOffset;
+        uint32_t triangleOffset;
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+        xxVector4 centerRadius;
+        xxVector4 coneApex;
+        xxVector4 coneAxisCutoff;
+    };
+
+    static bool Available(xxMesh const* mesh);
+    static int const* Cull(xxMesh const* mesh, xxMatrix4 const& world, xxMatrix4x2 const* frustum, xxVector3 const* eye, int& count);
+
+    static size_t TotalCount;
+    static size_t CulledCount;
+};
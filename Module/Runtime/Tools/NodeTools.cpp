@@ -5,10 +5,14 @@
 // https://github.com/metarutaiga/minamoto
 //==============================================================================
 #include "Runtime.h"
+#include <unordered_map>
+#include <unordered_set>
 #include <xxGraphicPlus/xxNode.h>
 #if HAVE_MINIGUI
 #include "MiniGUI/Window.h"
 #endif
+#include "Modifier/Modifier.h"
+#include "JobSystem.h"
 #include "NodeTools.h"
 
 //==============================================================================
@@ -48,61 +52,551 @@ xxNodePtr const& NodeTools::GetRoot(xxNodePtr const& node)
     return (*root);
 }
 //------------------------------------------------------------------------------
-xxNodePtr const& NodeTools::GetObject(xxNodePtr const& node, std::string const& name)
+static xxNode* GetTrunk(xxNode* root, xxNode* node)
+{
+    while (node && node->GetParent().get() != root)
+        node = node->GetParent().get();
+    return node;
+}
+//------------------------------------------------------------------------------
+static xxNodePtr const& GetTrunk(xxNodePtr const& root, xxNodePtr const& node)
+{
+    xxNodePtr const* trunk = &node;
+    while ((*trunk)->GetParent() && (*trunk)->GetParent() != root)
+        trunk = &(*trunk)->GetParent();
+    return (*trunk);
+}
+//------------------------------------------------------------------------------
+struct Trunk
+{
+    std::weak_ptr<xxNode> node;
+    NodeTools::Statistic statistic;
+    std::vector<xxNode*> bones;
+    size_t revision;
+    bool active;
+};
+//------------------------------------------------------------------------------
+struct Root
+{
+    std::weak_ptr<xxNode> root;
+    NodeTools::Statistic statistic;
+    std::unordered_map<xxNode*, Trunk> trunks;
+    std::unordered_set<xxNode*> serials;
+    std::unordered_set<xxNode*> windows;
+    std::vector<std::weak_ptr<xxNode>> dirties;
+    std::unordered_map<std::string, std::weak_ptr<xxNode>> names;
+    std::unordered_set<std::string> misses;
+    std::unordered_map<xxNode*, size_t> bones;
+    xxMatrix4 world;
+    size_t active;
+    size_t revision;
+    size_t missRevision;
+    bool indexed;
+};
+static std::unordered_map<xxNode*, Root> roots;
+//------------------------------------------------------------------------------
+static Root* FindRoot(xxNodePtr const& node, bool create)
+{
+    auto it = roots.find(node.get());
+    if (it != roots.end() && (*it).second.root.expired())
+    {
+        roots.erase(it);
+        it = roots.end();
+    }
+    if (it != roots.end())
+        return &(*it).second;
+    if (node == nullptr || create == false)
+        return nullptr;
+
+    // Roots of released trees are only dropped when another root is created
+    for (auto it = roots.begin(); it != roots.end();)
+    {
+        if ((*it).second.root.expired())
+        {
+            it = roots.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    Root& output = roots[node.get()];
+    output.root = node;
+    output.statistic = {};
+    output.world = node->WorldMatrix;
+    output.active = 0;
+    output.revision = 0;
+    output.missRevision = 0;
+    output.indexed = false;
+    return &output;
+}
+//------------------------------------------------------------------------------
+static void InsertName(Root& data, xxNodePtr const& node)
 {
-    xxNodePtr const* output = nullptr;
     xxNode::Traversal(node, [&](xxNodePtr const& node)
     {
-        if (node->Name == name)
-            output = &node;
-        return output == nullptr;
+        std::weak_ptr<xxNode>& weak = data.names[node->Name];
+        if (weak.expired())
+            weak = node;
+        return true;
     });
-    if (output == nullptr)
+}
+//------------------------------------------------------------------------------
+static void RemoveName(Root& data, xxNodePtr const& node)
+{
+    xxNode::Traversal(node, [&](xxNodePtr const& node)
     {
-        static xxNodePtr empty;
-        return empty;
-    }
-    return (*output);
+        auto it = data.names.find(node->Name);
+        if (it != data.names.end() && (*it).second.lock() == node)
+            data.names.erase(it);
+        return true;
+    });
 }
 //------------------------------------------------------------------------------
-void NodeTools::UpdateNodeFlags(xxNodePtr const& node)
+static void MarkBone(xxNode* root, xxNode* trunk, xxNodePtr const& node)
 {
-    xxNode::Traversal(node, [](xxNodePtr const& node)
+    for (auto const& data : node->Bones)
     {
-        node->Flags |= xxNode::UPDATE_SKIP;
-        for (auto const& data : node->Bones)
+        if (data.bone.use_count())
         {
-            if (data.bone.use_count())
+            xxNodePtr const& bone = (xxNodePtr&)data.bone;
+            bone->Flags |= xxNode::UPDATE_NEED;
+            if (GetTrunk(root, bone.get()) != trunk)
             {
-                xxNodePtr const& bone = (xxNodePtr&)data.bone;
-                bone->Flags |= xxNode::UPDATE_NEED;
+                trunk->Flags |= NodeTools::UPDATE_SERIAL_FLAG;
+                xxNode* parent = bone.get();
+                while (parent && (parent->Flags & xxNode::UPDATE_SKIP))
+                {
+                    parent->Flags &= ~xxNode::UPDATE_SKIP;
+                    parent = parent->GetParent().get();
+                }
             }
         }
+    }
+}
+//------------------------------------------------------------------------------
+static void UpdateTrunk(xxNode* root, xxNodePtr const& trunk, Trunk& output)
+{
+    trunk->Flags &= ~(NodeTools::UPDATE_SERIAL_FLAG | NodeTools::UPDATE_DIRTY_FLAG);
+    output.statistic = {};
+    output.bones.clear();
+
+#if HAVE_MINIGUI
+    // Windows keep their own flags, Window::Update only visits the marked ones
+    if (trunk->Flags & MiniGUI::Window::WINDOW_CLASS)
+        return;
+#endif
+
+    xxNode::Traversal(trunk, [](xxNodePtr const& node)
+    {
+        node->Flags |= xxNode::UPDATE_SKIP;
+        node->Flags &= ~xxNode::UPDATE_NEED;
+        return true;
+    });
+
+    xxNode::Traversal(trunk, [root, &trunk](xxNodePtr const& node)
+    {
+        MarkBone(root, trunk.get(), node);
         if (node->Mesh)
         {
             node->Flags |= xxNode::UPDATE_NEED;
         }
-#if HAVE_MINIGUI
-        if (node->Flags & MiniGUI::Window::WINDOW_CLASS)
+        for (auto const& data : node->Modifiers)
         {
-            node->Flags |= xxNode::UPDATE_NEED;
+            if (data.modifier && data.modifier->DataType == Modifier::LIGHT)
+            {
+                node->Flags |= xxNode::UPDATE_NEED;
+                break;
+            }
         }
-#endif
         return true;
     });
 
-    xxNode::Traversal(node, [](xxNodePtr const& node)
+    xxNode::Traversal(trunk, [root](xxNodePtr const& node)
     {
         if (node->Flags & xxNode::UPDATE_NEED)
         {
-            xxNodePtr parent = node;
-            while (parent && (parent->Flags & xxNode::UPDATE_SKIP))
+            xxNode* parent = node.get();
+            while (parent && parent != root && (parent->Flags & xxNode::UPDATE_SKIP))
             {
                 parent->Flags &= ~xxNode::UPDATE_SKIP;
-                parent = parent->GetParent();
+                parent = parent->GetParent().get();
+            }
+        }
+        return true;
+    });
+
+    NodeTools::Statistic& statistic = output.statistic;
+    xxNode::Traversal(trunk, [&](xxNodePtr const& node)
+    {
+        for (auto const& data : node->Bones)
+        {
+            if (data.bone.use_count())
+            {
+                xxNodePtr const& bone = (xxNodePtr&)data.bone;
+                if ((bone->Flags & NodeTools::TEST_CHECK_FLAG) == 0)
+                {
+                    bone->Flags |= NodeTools::TEST_CHECK_FLAG;
+                    output.bones.push_back(bone.get());
+                }
             }
         }
+        statistic.nodeTotal++;
+        statistic.modifierTotal += node->Modifiers.size();
+        if ((node->Flags & xxNode::UPDATE_SKIP) == 0)
+        {
+            statistic.nodeActive++;
+            statistic.modifierActive += node->Modifiers.size();
+        }
         return true;
     });
+    for (xxNode* bone : output.bones)
+    {
+        bone->Flags &= ~NodeTools::TEST_CHECK_FLAG;
+    }
+}
+//------------------------------------------------------------------------------
+static void Accumulate(NodeTools::Statistic& statistic, NodeTools::Statistic const& other, int sign)
+{
+    statistic.nodeTotal += sign * other.nodeTotal;
+    statistic.nodeActive += sign * other.nodeActive;
+    statistic.modifierTotal += sign * other.modifierTotal;
+    statistic.modifierActive += sign * other.modifierActive;
+}
+//------------------------------------------------------------------------------
+static void InsertTrunk(Root& data, Trunk const& trunk)
+{
+    Accumulate(data.statistic, trunk.statistic, 1);
+    data.active += trunk.active ? 1 : 0;
+
+    // Bones shared by trunks are counted once
+    for (xxNode* bone : trunk.bones)
+    {
+        data.bones[bone]++;
+    }
+    data.statistic.bone = data.bones.size();
+}
+//------------------------------------------------------------------------------
+static void RemoveTrunk(Root& data, xxNode* trunk)
+{
+    auto it = data.trunks.find(trunk);
+    if (it == data.trunks.end())
+        return;
+    Accumulate(data.statistic, (*it).second.statistic, -1);
+    data.active -= (*it).second.active ? 1 : 0;
+    for (xxNode* bone : (*it).second.bones)
+    {
+        auto found = data.bones.find(bone);
+        if (found != data.bones.end() && --(*found).second == 0)
+            data.bones.erase(found);
+    }
+    data.statistic.bone = data.bones.size();
+    data.trunks.erase(it);
+    data.serials.erase(trunk);
+    data.windows.erase(trunk);
+}
+//------------------------------------------------------------------------------
+bool NodeTools::AttachChild(xxNodePtr const& parent, xxNodePtr const& child)
+{
+    if (parent == nullptr || parent->AttachChild(child) == false)
+        return false;
+    roots.erase(child.get());
+    Root* data = FindRoot(GetRoot(parent), false);
+    if (data && data->indexed)
+    {
+        InsertName(*data, child);
+        data->misses.clear();
+    }
+#if HAVE_MINIGUI
+    if (child->Flags & MiniGUI::Window::WINDOW_CLASS)
+    {
+        MiniGUI::Window::Cast(child)->MarkDirty();
+    }
+#endif
+    Invalidate(child);
+    return true;
+}
+//------------------------------------------------------------------------------
+bool NodeTools::DetachChild(xxNodePtr const& parent, xxNodePtr const& child)
+{
+    if (parent == nullptr)
+        return false;
+    xxNodePtr const& root = GetRoot(parent);
+    Root* data = FindRoot(root, false);
+    if (data)
+    {
+        if (data->indexed)
+        {
+            RemoveName(*data, child);
+        }
+        if (parent == root)
+        {
+            RemoveTrunk(*data, child.get());
+            child->Flags &= ~UPDATE_DIRTY_FLAG;
+            data->revision++;
+        }
+        else
+        {
+            Invalidate(parent);
+        }
+    }
+    return parent->DetachChild(child);
+}
+//------------------------------------------------------------------------------
+void NodeTools::Invalidate(xxNodePtr const& node)
+{
+    // Flags and statistics are only recomputed for trunks invalidated here, so a mesh, a modifier
+    // or a bone changed on a node below an updated root must be followed by a call
+    xxNodePtr const& root = GetRoot(node);
+    Root* data = FindRoot(root, false);
+    if (data == nullptr || node == root)
+        return;
+    xxNodePtr const& trunk = GetTrunk(root, node);
+    if (trunk->Flags & UPDATE_DIRTY_FLAG)
+        return;
+    trunk->Flags |= UPDATE_DIRTY_FLAG;
+    data->dirties.push_back(trunk);
+}
+//------------------------------------------------------------------------------
+void NodeTools::SetName(xxNodePtr const& node, std::string const& name)
+{
+    Root* data = FindRoot(GetRoot(node), false);
+    if (data && data->indexed)
+    {
+        auto it = data->names.find(node->Name);
+        if (it != data->names.end() && (*it).second.lock() == node)
+            data->names.erase(it);
+        std::weak_ptr<xxNode>& weak = data->names[name];
+        if (weak.expired())
+            weak = node;
+        data->misses.erase(name);
+    }
+    node->Name = name;
+}
+//------------------------------------------------------------------------------
+xxNodePtr NodeTools::GetObject(xxNodePtr const& node, std::string const& name)
+{
+    if (node == nullptr)
+        return xxNodePtr();
+
+    xxNodePtr const& root = GetRoot(node);
+    Root* data = FindRoot(root, true);
+    if (data->indexed == false)
+    {
+        data->names.clear();
+        data->indexed = true;
+        InsertName(*data, root);
+    }
+
+    // Index
+    xxNodePtr output;
+    auto it = data->names.find(name);
+    if (it != data->names.end())
+    {
+        output = (*it).second.lock();
+        if (output == nullptr || output->Name != name)
+        {
+            data->names.erase(it);
+            output = nullptr;
+        }
+    }
+
+    // Names missing from the index are searched from the root once per revision
+    if (output == nullptr)
+    {
+        if (data->missRevision != data->revision)
+        {
+            data->missRevision = data->revision;
+            data->misses.clear();
+        }
+        if (data->misses.find(name) != data->misses.end())
+            return output;
+        xxNode::Traversal(root, [&](xxNodePtr const& node)
+        {
+            if (node->Name == name)
+                output = node;
+            return output == nullptr;
+        });
+        if (output == nullptr)
+        {
+            data->misses.insert(name);
+            return output;
+        }
+        data->names[name] = output;
+    }
+    for (xxNode* parent = output.get(); parent; parent = parent->GetParent().get())
+    {
+        if (parent == node.get())
+            return output;
+    }
+
+    // Duplicated names inside the searched subtree
+    output = nullptr;
+    xxNode::Traversal(node, [&](xxNodePtr const& node)
+    {
+        if (node->Name == name)
+            output = node;
+        return output == nullptr;
+    });
+    return output;
+}
+//------------------------------------------------------------------------------
+NodeTools::Statistic const& NodeTools::GetStatistic(xxNodePtr const& node)
+{
+    Root* data = FindRoot(node, false);
+    if (data == nullptr)
+    {
+        static Statistic empty;
+        return empty;
+    }
+    return data->statistic;
+}
+//------------------------------------------------------------------------------
+size_t NodeTools::GetRevision(xxNodePtr const& node)
+{
+    Root* data = FindRoot(node, false);
+    if (data == nullptr)
+        return 0;
+    return data->revision;
+}
+//------------------------------------------------------------------------------
+size_t NodeTools::GetRevision(xxNodePtr const& root, xxNodePtr const& trunk)
+{
+    Root* data = FindRoot(root, false);
+    if (data == nullptr || trunk == nullptr)
+        return 0;
+    auto it = data->trunks.find(trunk.get());
+    if (it == data->trunks.end() || (*it).second.node.lock() != trunk)
+        return 0;
+    return (*it).second.revision;
+}
+//------------------------------------------------------------------------------
+void NodeTools::UpdateNodeFlags(xxNodePtr const& node)
+{
+    Root* data = FindRoot(node, true);
+
+    xxNode* root = node.get();
+    bool updated = false;
+    for (int i = 0; i < 2; ++i)
+    {
+        for (auto const& weak : data->dirties)
+        {
+            xxNodePtr trunk = weak.lock();
+            if (trunk == nullptr || trunk->GetParent().get() != root)
+                continue;
+            if ((trunk->Flags & UPDATE_DIRTY_FLAG) == 0)
+                continue;
+            bool attached = data->trunks.find(trunk.get()) == data->trunks.end();
+            RemoveTrunk(*data, trunk.get());
+            Trunk& output = data->trunks[trunk.get()];
+            output.node = trunk;
+            output.revision = data->revision + 1;
+            UpdateTrunk(root, trunk, output);
+            output.active = (trunk->Flags & xxNode::UPDATE_SKIP) == 0;
+            InsertTrunk(*data, output);
+            if (trunk->Flags & UPDATE_SERIAL_FLAG)
+            {
+                data->serials.insert(trunk.get());
+            }
+#if HAVE_MINIGUI
+            if (trunk->Flags & MiniGUI::Window::WINDOW_CLASS)
+            {
+                data->windows.insert(trunk.get());
+                if (attached)
+                {
+                    trunk->Flags |= xxNode::UPDATE_NEED;
+                    MiniGUI::Window::Cast(trunk)->MarkDirty();
+                }
+            }
+#endif
+            updated = true;
+        }
+        data->dirties.clear();
+
+        // Children of the root were attached or detached without NodeTools
+        if (data->trunks.size() == node->GetChildCount())
+            break;
+        data->statistic = {};
+        data->trunks.clear();
+        data->serials.clear();
+        data->windows.clear();
+        data->bones.clear();
+        data->active = 0;
+        for (xxNodePtr const& child : (*node))
+        {
+            child->Flags |= UPDATE_DIRTY_FLAG;
+            data->dirties.push_back(child);
+        }
+    }
+
+    // Bones referenced across trunks may have been reset by a dirty trunk
+    if (updated)
+    {
+        data->revision++;
+        for (xxNode* serial : data->serials)
+        {
+            xxNodePtr trunk = data->trunks[serial].node.lock();
+            xxNode::Traversal(trunk, [root, serial](xxNodePtr const& node)
+            {
+                MarkBone(root, serial, node);
+                return true;
+            });
+        }
+    }
+
+#if HAVE_MINIGUI
+    // Windows only follow a moved root, the other changes are marked by their setters
+    if (memcmp(&data->world, &node->WorldMatrix, sizeof(xxMatrix4)) != 0)
+    {
+        data->world = node->WorldMatrix;
+        for (xxNode* window : data->windows)
+        {
+            xxNodePtr trunk = data->trunks[window].node.lock();
+            if (trunk == nullptr)
+                continue;
+            trunk->Flags |= xxNode::UPDATE_NEED;
+            MiniGUI::Window::Cast(trunk)->MarkDirty();
+        }
+    }
+#endif
+
+    // A trunk borrowing bones from another trunk keeps the root active
+    if (data->active || data->serials.empty() == false)
+        node->Flags &= ~xxNode::UPDATE_SKIP;
+    else
+        node->Flags |= xxNode::UPDATE_SKIP;
+}
+//------------------------------------------------------------------------------
+void NodeTools::UpdateParallel(xxNodePtr const& node, float time)
+{
+    static std::vector<xxNode*> parallel;
+    static std::vector<xxNode*> serial;
+    parallel.clear();
+    serial.clear();
+    for (xxNodePtr const& child : (*node))
+    {
+#if HAVE_MINIGUI
+        if (child->Flags & MiniGUI::Window::WINDOW_CLASS)
+            continue;
+#endif
+        if (child->Flags & UPDATE_SERIAL_FLAG)
+            serial.push_back(child.get());
+        else
+            parallel.push_back(child.get());
+    }
+
+    // Subtrees are independent unless their bones refer to another subtree
+    size_t count = std::min(parallel.size(), JobSystem::GetThreadCount() * 8);
+    JobSystem::Dispatch(count, [count, time](size_t index)
+    {
+        size_t begin = parallel.size() * index / count;
+        size_t end = parallel.size() * (index + 1) / count;
+        for (size_t i = begin; i < end; ++i)
+        {
+            parallel[i]->Update(time);
+        }
+    });
+    for (xxNode* child : serial)
+    {
+        child->Update(time);
+    }
 }
 //==============================================================================
@@ -11,10 +11,28 @@
 struct RuntimeAPI NodeTools
 {
     static constexpr size_t TEST_CHECK_FLAG = size_t(1) << (sizeof(size_t) * 8 - 1);
+    static constexpr size_t UPDATE_SERIAL_FLAG = size_t(1) << (sizeof(size_t) * 8 - 2);
+    static constexpr size_t UPDATE_DIRTY_FLAG = size_t(1) << (sizeof(size_t) * 8 - 3);
+    struct Statistic
+    {
+        size_t bone;
+        size_t nodeTotal;
+        size_t nodeActive;
+        size_t modifierTotal;
+        size_t modifierActive;
+    };
 #if HAVE_MINIGUI
     static MiniGUI::WindowPtr const& GetRoot(MiniGUI::WindowPtr const& window);
 #endif
     static xxNodePtr const& GetRoot(xxNodePtr const& node);
-    static xxNodePtr const& GetObject(xxNodePtr const& node, std::string const& name);
+    static xxNodePtr GetObject(xxNodePtr const& node, std::string const& name);
+    static bool AttachChild(xxNodePtr const& parent, xxNodePtr const& child);
+    static bool DetachChild(xxNodePtr const& parent, xxNodePtr const& child);
+    static void Invalidate(xxNodePtr const& node);
+    static void SetName(xxNodePtr const& node, std::string const& name);
+    static Statistic const& GetStatistic(xxNodePtr const& node);
+    static size_t GetRevision(xxNodePtr const& node);
+    static size_t GetRevision(xxNodePtr const& root, xxNodePtr const& trunk);
     static void UpdateNodeFlags(xxNodePtr const& node);
+    static void UpdateParallel(xxNodePtr const& node, float time);
 };
@@ -0,0 +1,289 @@
+//==============================================================================
+// Minamoto : OcclusionTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <xxGraphicPlus/xxCamera.h>
+#include <xxGraphicPlus/xxMaterial.h>
+#include <xxGraphicPlus/xxMesh.h>
+#include <xxGraphicPlus/xxNode.h>
+#include "LODTools.h"
+#include "OcclusionTools.h"
+
+// Depth is stored as inverse view depth, larger is nearer and zero is empty
+static constexpr int TILE_WIDTH = OcclusionTools::WIDTH / OcclusionTools::TILE;
+static constexpr int TILE_HEIGHT = OcclusionTools::HEIGHT / OcclusionTools::TILE;
+static constexpr float OCCLUDER_SIZE = 0.125f;
+static constexpr float OCCLUSION_NEAR = 0.01f;
+
+//==============================================================================
+using v4mask = decltype(v4sf{} < v4sf{});
+struct ScreenVertex
+{
+    float x;
+    float y;
+    float z;
+};
+static v4sf occlusionDepth[OcclusionTools::WIDTH * OcclusionTools::HEIGHT / 4];
+static float occlusionTileMin[TILE_WIDTH * TILE_HEIGHT];
+static float occlusionTileMax[TILE_WIDTH * TILE_HEIGHT];
+static std::vector<ScreenVertex> occlusionVertices;
+static xxVector3 cameraLocation;
+static xxVector3 cameraDirection;
+static xxVector3 cameraRight;
+static xxVector3 cameraUp;
+static float frustumLeft;
+static float frustumTop;
+static float frustumScaleX;
+static float frustumScaleY;
+static bool occlusionReady = false;
+size_t OcclusionTools::OccluderCount;
+size_t OcclusionTools::TriangleCount;
+size_t OcclusionTools::OccludedCount;
+//------------------------------------------------------------------------------
+static void RasterizeTriangle(ScreenVertex const& v0, ScreenVertex const& v1, ScreenVertex const& v2)
+{
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::fabs(area) < 1.0e-6f)
+        return;
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float inverse = 1.0f / std::fabs(area);
+
+    // Edge functions E(x, y) = A * x + B * y + C, positive inside for either winding
+    float a0 = sign * (v1.y - v2.y), b0 = sign * (v2.x - v1.x), c0 = sign * (v1.x * v2.y - v2.x * v1.y);
+    float a1 = sign * (v2.y - v0.y), b1 = sign * (v0.x - v2.x), c1 = sign * (v2.x * v0.y - v0.x * v2.y);
+    float a2 = sign * (v0.y - v1.y), b2 = sign * (v1.x - v0.x), c2 = sign * (v0.x * v1.y - v1.x * v0.y);
+    float az = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inverse;
+    float bz = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inverse;
+    float cz = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * inverse;
+
+    int minX = std::max(int(std::min(std::min(v0.x, v1.x), v2.x)), 0) & ~3;
+    int maxX = std::min(int(std::max(std::max(v0.x, v1.x), v2.x)), OcclusionTools::WIDTH - 1);
+    int minY = std::max(int(std::min(std::min(v0.y, v1.y), v2.y)), 0);
+    int maxY = std::min(int(std::max(std::max(v0.y, v1.y), v2.y)), OcclusionTools::HEIGHT - 1);
+
+    v4sf const lane = { 0.5f, 1.5f, 2.5f, 3.5f };
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        float e0 = b0 * py + c0;
+        float e1 = b1 * py + c1;
+        float e2 = b2 * py + c2;
+        float ez = bz * py + cz;
+        v4sf* row = occlusionDepth + (y * OcclusionTools::WIDTH) / 4;
+        for (int x = minX; x <= maxX; x += 4)
+        {
+            v4sf px = lane + float(x);
+            v4mask inside = (a0 * px + e0 >= 0.0f) & (a1 * px + e1 >= 0.0f) & (a2 * px + e2 >= 0.0f);
+            v4sf depth = az * px + ez;
+            v4sf& old = row[x / 4];
+            v4mask nearer = inside & (depth > old);
+            old = (v4sf)(((v4mask)depth & nearer) | ((v4mask)old & ~nearer));
+        }
+    }
+}
+//==============================================================================
+void OcclusionTools::Begin(xxCamera const* camera)
+{
+    occlusionReady = false;
+    OccluderCount = 0;
+    TriangleCount = 0;
+    OccludedCount = 0;
+    if (camera == nullptr || camera->FrustumRight <= camera->FrustumLeft || camera->FrustumTop <= camera->FrustumBottom)
+        return;
+
+    cameraLocation = camera->Location;
+    cameraDirection = camera->Direction;
+    cameraRight = camera->Right;
+    cameraUp = camera->Up;
+    frustumLeft = camera->FrustumLeft;
+    frustumTop = camera->FrustumTop;
+    frustumScaleX = WIDTH / (camera->FrustumRight - camera->FrustumLeft);
+    frustumScaleY = HEIGHT / (camera->FrustumTop - camera->FrustumBottom);
+    memset(occlusionDepth, 0, sizeof(occlusionDepth));
+    occlusionReady = true;
+}
+//------------------------------------------------------------------------------
+bool OcclusionTools::Occluder(xxNode const* node)
+{
+    if (occlusionReady == false || TriangleCount >= TRIANGLE_MAX)
+        return false;
+    xxMesh* mesh = node->Mesh.get();
+    if (mesh == nullptr || mesh->Skinning || (node->Material && node->Material->Blending))
+        return false;
+
+    // Only nodes covering a large part of the screen are worth rasterizing
+    xxVector4 const& bound = node->WorldBound;
+    float distance = cameraDirection.Dot(bound.xyz - cameraLocation) - bound.w;
+    if (distance <= OCCLUSION_NEAR)
+        return false;
+    return bound.w * frustumScaleY >= distance * OCCLUDER_SIZE * HEIGHT;
+}
+//------------------------------------------------------------------------------
+void OcclusionTools::Rasterize(xxNode const* node, xxMeshPtr const& base)
+{
+    if (occlusionReady == false || base == nullptr)
+        return;
+    // Simplified levels may bulge outside the surface, so only the full mesh is a safe occluder
+    xxMeshPtr const& mesh = LODTools::GetLevel(base, 0);
+
+    // Camera space basis of the world matrix
+    xxMatrix4 const& world = node->WorldMatrix;
+    xxVector3 const& axisX = world.v[0].xyz;
+    xxVector3 const& axisY = world.v[1].xyz;
+    xxVector3 const& axisZ = world.v[2].xyz;
+    xxVector3 origin = world.v[3].xyz - cameraLocation;
+    xxVector4 d = { cameraDirection.Dot(axisX), cameraDirection.Dot(axisY), cameraDirection.Dot(axisZ), cameraDirection.Dot(origin) };
+    xxVector4 r = { cameraRight.Dot(axisX), cameraRight.Dot(axisY), cameraRight.Dot(axisZ), cameraRight.Dot(origin) };
+    xxVector4 u = { cameraUp.Dot(axisX), cameraUp.Dot(axisY), cameraUp.Dot(axisZ), cameraUp.Dot(origin) };
+
+    int vertexCount = mesh->Count[xxMesh::VERTEX];
+    occlusionVertices.resize(vertexCount);
+    auto positions = mesh->GetPosition();
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        xxVector3 const& p = (*positions++);
+        float depth = d.x * p.x + d.y * p.y + d.z * p.z + d.w;
+        ScreenVertex& vertex = occlusionVertices[i];
+        if (depth <= OCCLUSION_NEAR)
+        {
+            vertex.z = -1.0f;
+            continue;
+        }
+        float inverse = 1.0f / depth;
+        vertex.x = ((r.x * p.x + r.y * p.y + r.z * p.z + r.w) * inverse - frustumLeft) * frustumScaleX;
+        vertex.y = (frustumTop - (u.x * p.x + u.y * p.y + u.z * p.z + u.w) * inverse) * frustumScaleY;
+        vertex.z = inverse;
+    }
+
+    int indexCount = mesh->Count[xxMesh::INDEX];
+    if (indexCount == 0)
+        indexCount = vertexCount;
+    for (int i = 0; i + 2 < indexCount && TriangleCount < TRIANGLE_MAX; i += 3)
+    {
+        uint32_t i0 = i + 0;
+        uint32_t i1 = i + 1;
+        uint32_t i2 = i + 2;
+        if (mesh->Count[xxMesh::INDEX] && vertexCount < 65536)
+        {
+            i0 = ((uint16_t*)mesh->Index)[i0];
+            i1 = ((uint16_t*)mesh->Index)[i1];
+            i2 = ((uint16_t*)mesh->Index)[i2];
+        }
+        else if (mesh->Count[xxMesh::INDEX])
+        {
+            i0 = ((uint32_t*)mesh->Index)[i0];
+            i1 = ((uint32_t*)mesh->Index)[i1];
+            i2 = ((uint32_t*)mesh->Index)[i2];
+        }
+        if (i0 >= uint32_t(vertexCount) || i1 >= uint32_t(vertexCount) || i2 >= uint32_t(vertexCount))
+            continue;
+
+        // Triangles crossing the near plane are skipped, which keeps the buffer conservative
+        ScreenVertex const& v0 = occlusionVertices[i0];
+        ScreenVertex const& v1 = occlusionVertices[i1];
+        ScreenVertex const& v2 = occlusionVertices[i2];
+        if (v0.z < 0.0f || v1.z < 0.0f || v2.z < 0.0f)
+            continue;
+        RasterizeTriangle(v0, v1, v2);
+        TriangleCount++;
+    }
+    OccluderCount++;
+}
+//------------------------------------------------------------------------------
+void OcclusionTools::Finish()
+{
+    if (occlusionReady == false)
+        return;
+
+    for (int ty = 0; ty < TILE_HEIGHT; ++ty)
+    {
+        for (int tx = 0; tx < TILE_WIDTH; ++tx)
+        {
+            v4sf minimum = occlusionDepth[(ty * TILE * WIDTH + tx * TILE) / 4];
+            v4sf maximum = minimum;
+            for (int y = 0; y < TILE; ++y)
+            {
+                v4sf const* row = occlusionDepth + ((ty * TILE + y) * WIDTH + tx * TILE) / 4;
+                for (int x = 0; x < TILE / 4; ++x)
+                {
+                    v4mask less = row[x] < minimum;
+                    v4mask greater = row[x] > maximum;
+                    minimum = (v4sf)(((v4mask)row[x] & less) | ((v4mask)minimum & ~less));
+                    maximum = (v4sf)(((v4mask)row[x] & greater) | ((v4mask)maximum & ~greater));
+                }
+            }
+            occlusionTileMin[ty * TILE_WIDTH + tx] = std::min(std::min(minimum[0], minimum[1]), std::min(minimum[2], minimum[3]));
+            occlusionTileMax[ty * TILE_WIDTH + tx] = std::max(std::max(maximum[0], maximum[1]), std::max(maximum[2], maximum[3]));
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool OcclusionTools::Visible(xxVector4 const& bound)
+{
+    if (occlusionReady == false || OccluderCount == 0 || bound.w <= 0.0f)
+        return true;
+
+    xxVector3 offset = bound.xyz - cameraLocation;
+    float center = cameraDirection.Dot(offset);
+    float distance = center - bound.w;
+    if (distance <= OCCLUSION_NEAR)
+        return true;
+
+    // Screen rectangle of the box around the sphere in camera space, which contains the sphere off axis too
+    float inverse = 1.0f / distance;
+    float distant = 1.0f / (center + bound.w);
+    float right = cameraRight.Dot(offset);
+    float up = cameraUp.Dot(offset);
+    float left = std::min((right - bound.w) * inverse, (right - bound.w) * distant);
+    float top = std::max((up + bound.w) * inverse, (up + bound.w) * distant);
+    right = std::max((right + bound.w) * inverse, (right + bound.w) * distant);
+    float bottom = std::min((up - bound.w) * inverse, (up - bound.w) * distant);
+    int minX = std::max(int(std::floor((left - frustumLeft) * frustumScaleX)), 0);
+    int maxX = std::min(int(std::floor((right - frustumLeft) * frustumScaleX)), WIDTH - 1);
+    int minY = std::max(int(std::floor((frustumTop - top) * frustumScaleY)), 0);
+    int maxY = std::min(int(std::floor((frustumTop - bottom) * frustumScaleY)), HEIGHT - 1);
+    if (minX > maxX || minY > maxY)
+        return true;
+
+    float nearest = inverse;
+    float const* depth = (float const*)occlusionDepth;
+    for (int ty = minY / TILE; ty <= maxY / TILE; ++ty)
+    {
+        for (int tx = minX / TILE; tx <= maxX / TILE; ++tx)
+        {
+            if (occlusionTileMin[ty * TILE_WIDTH + tx] > nearest)
+                continue;
+            if (occlusionTileMax[ty * TILE_WIDTH + tx] <= nearest)
+                return true;
+            int x0 = std::max(minX, tx * TILE);
+            int x1 = std::min(maxX, tx * TILE + TILE - 1);
+            int y0 = std::max(minY, ty * TILE);
+            int y1 = std::min(maxY, ty * TILE + TILE - 1);
+            for (int py = y0; py <= y1; ++py)
+            {
+                for (int px = x0; px <= x1; ++px)
+                {
+                    if (depth[py * WIDTH + px] <= nearest)
+                        return true;
+                }
+            }
+        }
+    }
+
+    OccludedCount++;
+    return false;
+}
+//------------------------------------------------------------------------------
+float const* OcclusionTools::GetDepth()
+{
+    return (float const*)occlusionDepth;
+}
+//------------------------------------------------------------------------------
+float const* OcclusionTools::GetTile()
+{
+    return occlusionTileMin;
+}
+//==============================================================================
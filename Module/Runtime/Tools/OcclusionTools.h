@@ -0,0 +1,30 @@
+//==============================================================================
+// Minamoto : OcclusionTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI OcclusionTools
+{
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 128;
+    static constexpr int TILE = 8;
+    static constexpr int TRIANGLE_MAX = 65536;
+
+    static void Begin(xxCamera const* camera);
+    static bool Occluder(xxNode const* node);
+    static void Rasterize(xxNode const* node, xxMeshPtr const& mesh);
+    static void Finish();
+    static bool Visible(xxVector4 const& bound);
+
+    static float const* GetDepth();
+    static float const* GetTile();
+
+    static size_t OccluderCount;
+    static size_t TriangleCount;
+    static size_t OccludedCount;
+};
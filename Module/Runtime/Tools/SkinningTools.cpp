@@ -0,0 +1,351 @@
+//==============================================================================
+// Minamoto : SkinningTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <unordered_map>
+#include <xxGraphicPlus/xxMaterial.h>
+#include <xxGraphicPlus/xxMesh.h>
+#include <xxGraphicPlus/xxNode.h>
+#include "JobSystem.h"
+#include "SkinningTools.h"
+
+#define SKINNING_CHUNK 4096
+
+//==============================================================================
+struct SkeletonKey
+{
+    void const* bones;
+    size_t count;
+    uint64_t skeleton;
+    uint32_t frame;
+};
+struct SkinnedKey
+{
+    xxNode const* node;
+    xxMesh const* source;
+    bool operator == (SkinnedKey const& other) const { return node == other.node && source == other.source; }
+};
+struct SkinnedHash
+{
+    size_t operator () (SkinnedKey const& key) const { return std::hash<void const*>()(key.node) ^ (std::hash<void const*>()(key.source) << 1); }
+};
+struct SkinnedMesh
+{
+    std::weak_ptr<xxMesh> source;
+    xxMeshPtr meshes[2];
+    int index;
+    uint32_t version;
+    uint32_t frame;
+};
+struct SkinningJob
+{
+    xxNode const* node;
+    xxMesh* source;
+    xxMesh* output;
+    int begin;
+    int end;
+};
+static std::unordered_map<xxNode const*, SkeletonKey> skeletonKeys;
+static std::unordered_map<uint64_t, SkinningTools::Palette> palettes;
+static std::unordered_map<SkinnedKey, SkinnedMesh, SkinnedHash> skinnedMeshes;
+static std::unordered_map<xxMaterial const*, std::weak_ptr<xxMaterial>> softwareMaterials;
+static std::vector<SkinningJob> skinningJobs;
+static uint32_t frame = 1;
+static uint32_t paletteVersion = 0;
+//------------------------------------------------------------------------------
+bool SkinningTools::Force;
+size_t SkinningTools::PaletteCount;
+size_t SkinningTools::ReusedCount;
+size_t SkinningTools::SkinnedCount;
+size_t SkinningTools::SkippedCount;
+//------------------------------------------------------------------------------
+static uint64_t GetSkeleton(xxNode const* node)
+{
+    // Bones can be edited in place, so the skeleton is hashed once per frame
+    SkeletonKey& key = skeletonKeys[node];
+    if (key.frame == frame && key.bones == node->Bones.data() && key.count == node->Bones.size())
+        return key.skeleton;
+    key.frame = frame;
+
+    // Nodes sharing bones and bind poses share a palette
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto combine = [&hash](void const* data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<uint8_t const*>(data)[i];
+            hash *= 0x100000001B3ull;
+        }
+    };
+    for (auto const& data : node->Bones)
+    {
+        xxNode* bone = data.bone.lock().get();
+        combine(&bone, sizeof(bone));
+        combine(&data.skinMatrix, sizeof(data.skinMatrix));
+    }
+    key.bones = node->Bones.data();
+    key.count = node->Bones.size();
+    key.skeleton = hash;
+    return hash;
+}
+//------------------------------------------------------------------------------
+static xxMeshPtr CreateOutput(xxMesh* source)
+{
+    xxMeshPtr output = xxMesh::Create(false, source->NormalCount, source->ColorCount, source->TextureCount);
+    if (output == nullptr)
+        return nullptr;
+    output->Name = source->Name;
+    output->SetVertexCount(source->Count[xxMesh::VERTEX]);
+    output->SetIndexCount(source->Count[xxMesh::INDEX]);
+
+    int indexSize = source->Count[xxMesh::VERTEX] < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+    memcpy(output->Index, source->Index, source->Count[xxMesh::INDEX] * indexSize);
+
+    // Colors and texture coordinates are not deformed
+    for (int i = 0; i < source->ColorCount; ++i)
+    {
+        auto input = source->GetColor(i);
+        auto color = output->GetColor(i);
+        for (int j = 0; j < source->Count[xxMesh::VERTEX]; ++j)
+            (*color++) = (*input++);
+    }
+    for (int i = 0; i < source->TextureCount; ++i)
+    {
+        auto input = source->GetTexture(i);
+        auto texture = output->GetTexture(i);
+        for (int j = 0; j < source->Count[xxMesh::VERTEX]; ++j)
+            (*texture++) = (*input++);
+    }
+
+    return output;
+}
+//------------------------------------------------------------------------------
+static void Deform(SkinningJob const& job)
+{
+    auto const& bones = job.node->Bones;
+    uint32_t boneCount = uint32_t(bones.size());
+    int normalCount = std::min(job.source->NormalCount, 3);
+
+    xxStrideIterator<xxVector3> inputPosition = job.source->GetPosition();
+    xxStrideIterator<xxVector3> inputBoneWeight = job.source->GetBoneWeight();
+    xxStrideIterator<uint32_t> inputBoneIndices = job.source->GetBoneIndices();
+    xxStrideIterator<xxVector3> outputPosition = job.output->GetPosition();
+    xxStrideIterator<xxVector3> inputNormals[3] = { job.source->GetNormal(0), job.source->GetNormal(1), job.source->GetNormal(2) };
+    xxStrideIterator<xxVector3> outputNormals[3] = { job.output->GetNormal(0), job.output->GetNormal(1), job.output->GetNormal(2) };
+
+    for (int i = job.begin; i < job.end; ++i)
+    {
+        xxVector3 weight = inputBoneWeight[i];
+        uint32_t indices = inputBoneIndices[i];
+        float weights[4] = { weight.x, weight.y, weight.z, 1.0f - weight.x - weight.y - weight.z };
+
+        // Blend the bone matrices column by column
+        v4sf c0 = {};
+        v4sf c1 = {};
+        v4sf c2 = {};
+        v4sf c3 = {};
+        for (int j = 0; j < 4; ++j)
+        {
+            uint32_t index = (indices >> (j * 8)) & 0xFF;
+            if (weights[j] == 0.0f || index >= boneCount)
+                continue;
+            xxMatrix4 const& matrix = bones[index].boneMatrix;
+            c0 += matrix.v[0].v * weights[j];
+            c1 += matrix.v[1].v * weights[j];
+            c2 += matrix.v[2].v * weights[j];
+            c3 += matrix.v[3].v * weights[j];
+        }
+
+        xxVector3 const& position = inputPosition[i];
+        xxVector4 result;
+        result.v = c0 * position.x + c1 * position.y + c2 * position.z + c3;
+        outputPosition[i] = result.xyz;
+        for (int j = 0; j < normalCount; ++j)
+        {
+            xxVector3 const& normal = inputNormals[j][i];
+            xxVector4 vector;
+            vector.v = c0 * normal.x + c1 * normal.y + c2 * normal.z;
+            float length = vector.xyz.Dot(vector.xyz);
+            if (length > 0.0f)
+                vector.v *= 1.0f / sqrtf(length);
+            outputNormals[j][i] = vector.xyz;
+        }
+    }
+}
+//==============================================================================
+SkinningTools::Palette const* SkinningTools::GetPalette(xxNode const* node)
+{
+    if (node == nullptr || node->Bones.empty())
+        return nullptr;
+
+    uint64_t skeleton = GetSkeleton(node);
+    Palette& palette = palettes[skeleton];
+    if (palette.frame == frame && palette.matrices.size() == node->Bones.size())
+    {
+        ReusedCount++;
+        return &palette;
+    }
+
+    // Bone matrices are already resolved by the node update
+    size_t count = node->Bones.size();
+    bool changed = palette.matrices.size() != count;
+    palette.matrices.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xxMatrix4x3 matrix = xxMatrix4x3::FromMatrix4(node->Bones[i].boneMatrix);
+        if (changed == false && memcmp(&palette.matrices[i], &matrix, sizeof(xxMatrix4x3)) == 0)
+            continue;
+        palette.matrices[i] = matrix;
+        changed = true;
+    }
+    palette.skeleton = skeleton;
+    palette.frame = frame;
+    if (changed)
+        palette.version = ++paletteVersion;
+    PaletteCount++;
+
+    return &palette;
+}
+//------------------------------------------------------------------------------
+int SkinningTools::GetBoneLimit()
+{
+    // Shader model 3 and OpenGL ES 2.0 only guarantee 256 and 128 vertex uniform vectors
+    char const* deviceString = xxGetInstanceName();
+    if (strstr(deviceString, "GL") || (strstr(deviceString, "Direct3D") && strstr(deviceString, "Direct3D 1") == nullptr))
+        return 75;
+    if (strstr(deviceString, "Vulkan"))
+        return 256;
+    return 1024;
+}
+//------------------------------------------------------------------------------
+bool SkinningTools::Software(xxNode const* node, xxMeshPtr const& mesh)
+{
+    if (mesh == nullptr || mesh->Skinning == false || node->Bones.empty())
+        return false;
+
+    if (Force)
+        return true;
+
+    // A material is built for one vertex layout, so every node sharing a material
+    // with an oversized skeleton is deformed on the CPU as well
+    xxMaterialPtr const& material = node->Material;
+    if (int(node->Bones.size()) > GetBoneLimit())
+    {
+        if (material)
+            softwareMaterials[material.get()] = material;
+        return true;
+    }
+    if (material == nullptr || softwareMaterials.empty())
+        return false;
+    auto it = softwareMaterials.find(material.get());
+    if (it == softwareMaterials.end())
+        return false;
+    if ((*it).second.lock() == material)
+        return true;
+    softwareMaterials.erase(it);
+    return false;
+}
+//------------------------------------------------------------------------------
+xxMeshPtr const& SkinningTools::Skin(xxNode const* node, xxMeshPtr const& mesh, bool deferred)
+{
+    // Each level of detail keeps its own outputs, so switching levels does not reallocate them
+    SkinnedKey key = { node, mesh.get() };
+    SkinnedMesh& skinned = skinnedMeshes[key];
+    bool rebuild = skinned.source.lock() != mesh || skinned.meshes[0] == nullptr || skinned.meshes[1] == nullptr;
+
+    // Every pass of the same frame shares the deformed vertices
+    if (rebuild == false && skinned.frame == frame)
+        return skinned.meshes[skinned.index];
+
+    Palette const* palette = GetPalette(node);
+    if (palette == nullptr)
+        return mesh;
+    if (rebuild)
+    {
+        skinned.source = mesh;
+        skinned.meshes[0] = CreateOutput(mesh.get());
+        skinned.meshes[1] = CreateOutput(mesh.get());
+        skinned.index = 0;
+        skinned.version = 0;
+        if (skinned.meshes[0] == nullptr || skinned.meshes[1] == nullptr)
+        {
+            skinnedMeshes.erase(key);
+            return mesh;
+        }
+    }
+    skinned.frame = frame;
+    if (skinned.version == palette->version)
+    {
+        SkippedCount++;
+        return skinned.meshes[skinned.index];
+    }
+    skinned.version = palette->version;
+
+    // Alternate the outputs so the buffer of the previous frame is not rewritten
+    skinned.index ^= 1;
+    xxMesh* output = skinned.meshes[skinned.index].get();
+    output->Invalidate();
+    int count = mesh->Count[xxMesh::VERTEX];
+    for (int begin = 0; begin < count; begin += SKINNING_CHUNK)
+    {
+        skinningJobs.push_back({ node, mesh.get(), output, begin, std::min(begin + SKINNING_CHUNK, count) });
+    }
+    SkinnedCount++;
+    if (deferred == false)
+        Finish();
+
+    return skinned.meshes[skinned.index];
+}
+//------------------------------------------------------------------------------
+void SkinningTools::Finish()
+{
+    JobSystem::Dispatch(skinningJobs.size(), [](size_t index)
+    {
+        Deform(skinningJobs[index]);
+    });
+    for (SkinningJob const& job : skinningJobs)
+    {
+        if (job.end == job.output->Count[xxMesh::VERTEX])
+            job.output->CalculateBound();
+    }
+    skinningJobs.clear();
+}
+//------------------------------------------------------------------------------
+void SkinningTools::Flush()
+{
+    frame++;
+    if ((frame & 63) != 0)
+        return;
+    for (auto it = skeletonKeys.begin(); it != skeletonKeys.end(); )
+    {
+        if (frame - it->second.frame > 64)
+            it = skeletonKeys.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = palettes.begin(); it != palettes.end(); )
+    {
+        if (frame - it->second.frame > 64)
+            it = palettes.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = skinnedMeshes.begin(); it != skinnedMeshes.end(); )
+    {
+        if (frame - it->second.frame > 64)
+            it = skinnedMeshes.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = softwareMaterials.begin(); it != softwareMaterials.end(); )
+    {
+        if (it->second.expired())
+            it = softwareMaterials.erase(it);
+        else
+            ++it;
+    }
+}
+//==============================================================================
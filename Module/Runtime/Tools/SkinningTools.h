@@ -0,0 +1,34 @@
+//==============================================================================
+// Minamoto : SkinningTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+
+struct RuntimeAPI SkinningTools
+{
+    struct Palette
+    {
+        std::vector<xxMatrix4x3> matrices;
+        uint64_t skeleton = 0;
+        uint32_t frame = 0;
+        uint32_t version = 0;
+    };
+
+    static Palette const* GetPalette(xxNode const* node);
+    static int GetBoneLimit();
+    static bool Software(xxNode const* node, xxMeshPtr const& mesh);
+    static xxMeshPtr const& Skin(xxNode const* node, xxMeshPtr const& mesh, bool deferred = false);
+    static void Finish();
+    static void Flush();
+
+    static bool Force;
+
+    static size_t PaletteCount;
+    static size_t ReusedCount;
+    static size_t SkinnedCount;
+    static size_t SkippedCount;
+};
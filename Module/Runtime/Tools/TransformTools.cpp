@@ -0,0 +1,92 @@
+//==============================================================================
+// Minamoto : TransformTools Source
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#include "Runtime.h"
+#include <xxGraphicPlus/xxNode.h>
+#include "TransformTools.h"
+
+//==============================================================================
+void TransformTools::Build(LinearTransform& transform, xxNodePtr const& root)
+{
+    transform.nodes.clear();
+    transform.parents.clear();
+    transform.indices.clear();
+    if (root == nullptr)
+        return;
+
+    // Breadth-first order keeps every parent in front of its children
+    transform.nodes.push_back(root.get());
+    transform.parents.push_back(UINT32_MAX);
+    for (size_t i = 0; i < transform.nodes.size(); ++i)
+    {
+        for (xxNodePtr const& child : (*transform.nodes[i]))
+        {
+            transform.nodes.push_back(child.get());
+            transform.parents.push_back(uint32_t(i));
+        }
+    }
+
+    for (size_t i = 0; i < transform.nodes.size(); ++i)
+    {
+        transform.indices[transform.nodes[i]] = uint32_t(i);
+    }
+    transform.localMatrices.resize(transform.nodes.size());
+    transform.worldMatrices.resize(transform.nodes.size());
+    Gather(transform);
+}
+//------------------------------------------------------------------------------
+void TransformTools::Gather(LinearTransform& transform)
+{
+    xxNode* const* nodes = transform.nodes.data();
+    xxMatrix4* localMatrices = transform.localMatrices.data();
+    for (size_t i = 0, count = transform.nodes.size(); i < count; ++i)
+    {
+        localMatrices[i] = nodes[i]->LocalMatrix;
+    }
+}
+//------------------------------------------------------------------------------
+void TransformTools::Update(LinearTransform& transform)
+{
+    size_t count = transform.nodes.size();
+    if (count == 0)
+        return;
+
+    uint32_t const* parents = transform.parents.data();
+    xxMatrix4 const* localMatrices = transform.localMatrices.data();
+    xxMatrix4* worldMatrices = transform.worldMatrices.data();
+
+    xxNodePtr const& parent = transform.nodes[0]->GetParent();
+    worldMatrices[0] = parent ? parent->WorldMatrix * localMatrices[0] : localMatrices[0];
+    for (size_t i = 1; i < count; ++i)
+    {
+        xxMatrix4 const& a = worldMatrices[parents[i]];
+        xxMatrix4 const& b = localMatrices[i];
+        xxMatrix4& c = worldMatrices[i];
+        c.v[0].v = __builtin_multiplyvector(&a.v->v, b.v[0].v);
+        c.v[1].v = __builtin_multiplyvector(&a.v->v, b.v[1].v);
+        c.v[2].v = __builtin_multiplyvector(&a.v->v, b.v[2].v);
+        c.v[3].v = __builtin_multiplyvector(&a.v->v, b.v[3].v);
+    }
+}
+//------------------------------------------------------------------------------
+void TransformTools::Scatter(LinearTransform& transform)
+{
+    xxNode* const* nodes = transform.nodes.data();
+    xxMatrix4 const* worldMatrices = transform.worldMatrices.data();
+    for (size_t i = 0, count = transform.nodes.size(); i < count; ++i)
+    {
+        nodes[i]->WorldMatrix = worldMatrices[i];
+    }
+}
+//------------------------------------------------------------------------------
+size_t TransformTools::GetIndex(LinearTransform const& transform, xxNode* node)
+{
+    auto it = transform.indices.find(node);
+    if (it == transform.indices.end())
+        return SIZE_MAX;
+    return (*it).second;
+}
+//==============================================================================
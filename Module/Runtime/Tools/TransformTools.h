@@ -0,0 +1,28 @@
+//==============================================================================
+// Minamoto : TransformTools Header
+//
+// Copyright (c) 2019-2024 TAiGA
+// https://github.com/metarutaiga/minamoto
+//==============================================================================
+#pragma once
+
+#include "Runtime.h"
+#include <unordered_map>
+
+struct RuntimeAPI TransformTools
+{
+    struct LinearTransform
+    {
+        std::vector<xxNode*>    nodes;
+        std::vector<uint32_t>   parents;
+        std::vector<xxMatrix4>  localMatrices;
+        std::vector<xxMatrix4>  worldMatrices;
+        std::unordered_map<xxNode*, uint32_t> indices;
+    };
+
+    static void Build(LinearTransform& transform, xxNodePtr const& root);
+    static void Gather(LinearTransform& transform);
+    static void Update(LinearTransform& transform);
+    static void Scatter(LinearTransform& transform);
+    static size_t GetIndex(LinearTransform const& transform, xxNode* node);
+};
@@ -5,9 +5,16 @@
 // https://github.com/metarutaiga/minamoto
 //==============================================================================
 #include <Interface.h>
+#include <thread>
 
+#include <xxGraphicPlus/xxCamera.h>
 #include <xxGraphicPlus/xxFile.h>
+#include <xxGraphicPlus/xxMesh.h>
 #include <xxGraphicPlus/xxNode.h>
+#include <Tools/JobSystem.h>
+#include <Tools/NodeTools.h>
+#include <Tools/OcclusionTools.h>
+#include <Tools/TransformTools.h>
 
 #if DirectXMath
 #include "DirectXMath.h"
@@ -20,6 +27,9 @@ using namespace DirectX;
 
 static void ValidateFile(float time, char* text, size_t count);
 static void ValidateNode(float time, char* text, size_t count);
+static void ValidateJob(float time, char* text, size_t count);
+static void ValidateTransform(float time, char* text, size_t count);
+static void ValidateOcclusion(float time, char* text, size_t count);
 
 //------------------------------------------------------------------------------
 moduleAPI const char* Create(const CreateData& createData)
@@ -66,6 +76,21 @@ moduleAPI bool Update(const UpdateData& updateData)
             {
                 ValidateNode(updateData.time, text, sizeof(text));
             }
+            ImGui::SameLine();
+            if (ImGui::Button("Job"))
+            {
+                ValidateJob(updateData.time, text, sizeof(text));
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Transform"))
+            {
+                ValidateTransform(updateData.time, text, sizeof(text));
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Occlusion"))
+            {
+                ValidateOcclusion(updateData.time, text, sizeof(text));
+            }
 
             ImGui::End();
         }
@@ -224,3 +249,206 @@ void ValidateNode(float time, char* text, size_t count)
 #endif
 }
 //------------------------------------------------------------------------------
+void ValidateJob(float time, char* text, size_t count)
+{
+    int step = 0;
+
+    // 1. Create 10000 Characters
+    xxNodePtr root = xxNode::Create();
+    for (int i = 0; i < 10000; ++i)
+    {
+        xxNodePtr character = xxNode::Create();
+        character->SetTranslate(xxVector3{ float(i % 100), float(i / 100), 0.0f });
+        character->UpdateRotateTranslateScale();
+        root->AttachChild(character);
+        xxNodePtr parent = character;
+        for (int j = 0; j < 32; ++j)
+        {
+            xxNodePtr bone = xxNode::Create();
+            bone->SetTranslate(xxVector3::Z);
+            bone->UpdateRotateTranslateScale();
+            parent->AttachChild(bone);
+            parent = (j % 8 == 7) ? character : bone;
+        }
+    }
+    step += snprintf(text + step, count - step, "Character : %zu\n", root->GetChildCount());
+
+    // 2. Update with 1..N Threads
+    size_t threadCount = std::thread::hardware_concurrency();
+    float single = 0.0f;
+    for (size_t i = 1; i <= threadCount; ++i)
+    {
+        JobSystem::Initialize(i);
+        NodeTools::UpdateParallel(root, time);
+        float begin = xxGetCurrentTime();
+        for (int j = 0; j < 10; ++j)
+        {
+            NodeTools::UpdateParallel(root, time);
+        }
+        float elapsed = (xxGetCurrentTime() - begin) / 10;
+        if (i == 1)
+            single = elapsed;
+        step += snprintf(text + step, count - step, "Thread (%zu) : %.0fus (x%.2f)\n", i, elapsed * 1000000, single / elapsed);
+    }
+    JobSystem::Initialize();
+}
+//------------------------------------------------------------------------------
+void ValidateTransform(float time, char* text, size_t count)
+{
+    int step = 0;
+
+    // 1. Create 100000 Nodes
+    std::vector<xxNodePtr> nodes;
+    xxNodePtr root = xxNode::Create();
+    nodes.push_back(root);
+    for (int i = 1; i < 100000; ++i)
+    {
+        xxNodePtr node = xxNode::Create();
+        node->SetRotate({ xxVector3::Y, -xxVector3::X, xxVector3::Z });
+        node->SetTranslate(xxVector3::WHITE);
+        node->UpdateRotateTranslateScale();
+        nodes[(i * 7919) % nodes.size()]->AttachChild(node);
+        nodes.push_back(node);
+    }
+    step += snprintf(text + step, count - step, "Node : %zu\n", nodes.size());
+
+    // 2. Recursive
+    root->Update(time);
+    float begin = xxGetCurrentTime();
+    for (int i = 0; i < 10; ++i)
+    {
+        root->Update(time);
+    }
+    float recursive = (xxGetCurrentTime() - begin) / 10;
+    step += snprintf(text + step, count - step, "Recursive : %.0fus\n", recursive * 1000000);
+    std::vector<xxMatrix4> worldMatrices;
+    for (xxNodePtr const& node : nodes)
+    {
+        worldMatrices.push_back(node->WorldMatrix);
+    }
+
+    // 3. Linear
+    TransformTools::LinearTransform transform;
+    TransformTools::Build(transform, root);
+    begin = xxGetCurrentTime();
+    for (int i = 0; i < 10; ++i)
+    {
+        TransformTools::Update(transform);
+    }
+    float linear = (xxGetCurrentTime() - begin) / 10;
+    step += snprintf(text + step, count - step, "Linear : %.0fus (x%.2f)\n", linear * 1000000, recursive / linear);
+
+    // 4. Linear with Gather / Scatter
+    begin = xxGetCurrentTime();
+    for (int i = 0; i < 10; ++i)
+    {
+        TransformTools::Gather(transform);
+        TransformTools::Update(transform);
+        TransformTools::Scatter(transform);
+    }
+    float scatter = (xxGetCurrentTime() - begin) / 10;
+    step += snprintf(text + step, count - step, "Linear with Gather / Scatter : %.0fus (x%.2f)\n", scatter * 1000000, recursive / scatter);
+
+    // 5. Compare
+    float difference = 0.0f;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        xxMatrix4 const& a = worldMatrices[i];
+        xxMatrix4 const& b = nodes[i]->WorldMatrix;
+        for (int j = 0; j < 4; ++j)
+        {
+            difference = std::max(difference, std::fabs(a.v[j].x - b.v[j].x));
+            difference = std::max(difference, std::fabs(a.v[j].y - b.v[j].y));
+            difference = std::max(difference, std::fabs(a.v[j].z - b.v[j].z));
+            difference = std::max(difference, std::fabs(a.v[j].w - b.v[j].w));
+        }
+    }
+    step += snprintf(text + step, count - step, "Difference : %f\n", difference);
+}
+//------------------------------------------------------------------------------
+void ValidateOcclusion(float time, char* text, size_t count)
+{
+    int step = 0;
+
+    // 1. Create 4 Walls and 10000 Nodes behind them
+    xxMeshPtr mesh = xxMesh::Create(false, 0, 0, 0);
+    mesh->SetVertexCount(4);
+    mesh->SetIndexCount(6);
+    auto positions = mesh->GetPosition();
+    (*positions++) = { -10.0f, 0.0f, -10.0f };
+    (*positions++) = {  10.0f, 0.0f, -10.0f };
+    (*positions++) = {  10.0f, 0.0f,  10.0f };
+    (*positions++) = { -10.0f, 0.0f,  10.0f };
+    uint16_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+    memcpy(mesh->Index, indices, sizeof(indices));
+
+    xxNodePtr root = xxNode::Create();
+    std::vector<xxNodePtr> walls;
+    for (int i = 0; i < 4; ++i)
+    {
+        xxNodePtr node = xxNode::Create();
+        node->Mesh = mesh;
+        node->SetTranslate({ i * 20.0f - 30.0f, 50.0f, 0.0f });
+        node->UpdateRotateTranslateScale();
+        root->AttachChild(node);
+        walls.push_back(node);
+    }
+    std::vector<xxNodePtr> nodes;
+    for (int i = 0; i < 10000; ++i)
+    {
+        xxNodePtr node = xxNode::Create();
+        node->SetTranslate({ (i % 100) * 2.0f - 99.0f, 60.0f + (i / 100) * 2.0f, (i % 7) * 2.0f - 6.0f });
+        node->UpdateRotateTranslateScale();
+        root->AttachChild(node);
+        nodes.push_back(node);
+    }
+    root->Update(time);
+    for (xxNodePtr const& node : walls)
+    {
+        node->WorldBound = { node->WorldMatrix.v[3].x, node->WorldMatrix.v[3].y, node->WorldMatrix.v[3].z, 14.2f };
+    }
+    for (xxNodePtr const& node : nodes)
+    {
+        node->WorldBound = { node->WorldMatrix.v[3].x, node->WorldMatrix.v[3].y, node->WorldMatrix.v[3].z, 0.5f };
+    }
+    step += snprintf(text + step, count - step, "Occluder : %zu\n", walls.size());
+    step += snprintf(text + step, count - step, "Node : %zu\n", nodes.size());
+
+    xxCameraPtr camera = xxCamera::Create();
+    camera->Location = xxVector3::ZERO;
+    camera->LookAt(xxVector3::Y, xxVector3::Z);
+    camera->SetFOV(16.0f / 9.0f, 60.0f, 10000.0f);
+    camera->Update();
+
+    // 2. Rasterize
+    float begin = xxGetCurrentTime();
+    for (int i = 0; i < 10; ++i)
+    {
+        OcclusionTools::Begin(camera.get());
+        for (xxNodePtr const& node : walls)
+        {
+            if (OcclusionTools::Occluder(node.get()))
+                OcclusionTools::Rasterize(node.get(), node->Mesh);
+        }
+        OcclusionTools::Finish();
+    }
+    float rasterize = (xxGetCurrentTime() - begin) / 10;
+    step += snprintf(text + step, count - step, "Rasterize : %.0fus (%zu triangles)\n", rasterize * 1000000, OcclusionTools::TriangleCount);
+
+    // 3. Test
+    size_t occluded = 0;
+    begin = xxGetCurrentTime();
+    for (int i = 0; i < 10; ++i)
+    {
+        occluded = 0;
+        for (xxNodePtr const& node : nodes)
+        {
+            if (OcclusionTools::Visible(node->WorldBound) == false)
+                occluded++;
+        }
+    }
+    float test = (xxGetCurrentTime() - begin) / 10;
+    step += snprintf(text + step, count - step, "Test : %.0fus\n", test * 1000000);
+    step += snprintf(text + step, count - step, "Draw Saved : %zu / %zu\n", occluded, nodes.size());
+}
+//------------------------------------------------------------------------------